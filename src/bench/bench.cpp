@@ -0,0 +1,291 @@
+#include <plog/Appenders/ConsoleAppender.h>
+#include <plog/Formatters/TxtFormatter.h>
+#include <plog/Init.h>
+#include <plog/Log.h>
+
+#include <uint256.h>
+
+#include <cxxopts.hpp>
+#include <tinyformat.h>
+
+#include <src/plotter_disk.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <bhd_types.h>
+#include <bls_key.h>
+#include <calc_diff.h>
+#include <chiapos_miner.h>
+#include <pos.h>
+#include <prover.h>
+#include <utils.h>
+
+namespace miner {
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+struct Arguments {
+    std::string plots_dir;                // plots are loaded from or created to this dir
+    std::string tmp_dir;                  // the temporary dir for plotting
+    std::vector<int> create_k_list;       // create one plot for each k in the list
+    int plots_per_k;                      // how many plots are created for each k
+    std::string challenges_path;          // the file contains challenges, one hex string per line
+    int num_challenges;                   // how many random challenges are generated if no file is provided
+    int filter_bits;                      // the plot filter, 0 to look up all plots
+    uint64_t difficulty;                  // difficulty to calculate iters
+    int dcf_bits;                         // difficulty constant factor bits
+    int base_iters;                       // base iters
+    int proof_candidates;                 // how many best proofs are fetched at the same time
+    bool no_cuda;                         // no GPU decompression
+    int max_compression_level;            // the max compression level is supported
+    int max_opened_plots;                 // 0 to keep all plots opened
+    int proving_budget_seconds;           // the decompression jobs of a challenge are dropped after it
+} g_args;
+
+/**
+ * @brief The latency records of a stage, the percentiles are reported at the end
+ *
+ * The stages are run one after another, so the reported rate is 1000 / avg latency, the calls one caller can make per
+ * second. The throughput of the whole replay is reported from the wall time.
+ */
+class Stage {
+public:
+    explicit Stage(std::string name) : m_name(std::move(name)) {}
+
+    template <typename Func>
+    auto Measure(Func&& func) -> decltype(func()) {
+        auto start = Clock::now();
+        struct Recorder {
+            Stage& stage;
+            Clock::time_point start;
+            ~Recorder() {
+                stage.m_records.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+            }
+        } recorder{*this, start};
+        return func();
+    }
+
+    void Report() const {
+        if (m_records.empty()) {
+            std::cout << tinyformat::format("%-16s no sample\n", m_name);
+            return;
+        }
+        std::vector<double> sorted = m_records;
+        std::sort(std::begin(sorted), std::end(sorted));
+        double total{0};
+        for (double ms : sorted) {
+            total += ms;
+        }
+        auto percentile = [&sorted](double p) -> double {
+            auto i = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+            return sorted[std::min(i, sorted.size() - 1)];
+        };
+        std::cout << tinyformat::format(
+                "%-16s n=%-6d p50=%9.3fms p90=%9.3fms p99=%9.3fms max=%9.3fms avg=%9.3fms 1/avg=%.1f/s\n", m_name,
+                sorted.size(), percentile(0.5), percentile(0.9), percentile(0.99), sorted.back(),
+                total / sorted.size(), total > 0 ? sorted.size() * 1000.0 / total : 0.0);
+    }
+
+private:
+    std::string m_name;
+    std::vector<double> m_records;
+};
+
+chiapos::Bytes MakeRandomBytes(std::mt19937_64& rng, std::size_t size) {
+    chiapos::Bytes res(size);
+    for (auto& b : res) {
+        b = static_cast<uint8_t>(rng());
+    }
+    return res;
+}
+
+/// Create an OG plot with random keys, the memo is made the same way as chia does so the proofs can be verified
+void CreatePlot(std::mt19937_64& rng, uint8_t k, std::string const& tmp_dir, std::string const& final_dir) {
+    chiapos::CWallet wallet(chiapos::CKey::CreateKeyWithRandomSeed(MakeRandomBytes(rng, 32)));
+    chiapos::PubKey farmer_pk = wallet.GetFarmerKey(0).GetPubKey();
+    chiapos::PubKey pool_pk = wallet.GetPoolKey(0).GetPubKey();
+    chiapos::Bytes local_master_sk = MakeRandomBytes(rng, chiapos::SK_LEN);
+    chiapos::PubKey local_pk =
+            chiapos::MakeArray<chiapos::PK_LEN>(Prover::CalculateLocalPkBytes(local_master_sk));
+    chiapos::PlotId plot_id = chiapos::MakePlotId(local_pk, farmer_pk, pool_pk);
+    chiapos::Bytes id = chiapos::MakeBytes(plot_id);
+    chiapos::Bytes memo = chiapos::MakeBytes(pool_pk);
+    memo.insert(std::end(memo), std::begin(farmer_pk), std::end(farmer_pk));
+    memo.insert(std::end(memo), std::begin(local_master_sk), std::end(local_master_sk));
+    std::string filename = tinyformat::format("plot-k%d-bench-%s.plot", (int)k, chiapos::BytesToHex(id));
+    PLOGI << tinyformat::format("creating plot k=%d: %s", (int)k, filename);
+    DiskPlotter().CreatePlotDisk(tmp_dir, tmp_dir, final_dir, filename, k, memo.data(), memo.size(), id.data(),
+                                 id.size());
+}
+
+std::vector<uint256> LoadChallenges(std::mt19937_64& rng) {
+    std::vector<uint256> challenges;
+    if (!g_args.challenges_path.empty()) {
+        std::ifstream in(g_args.challenges_path);
+        if (!in.is_open()) {
+            throw std::runtime_error(tinyformat::format("cannot open challenges file: %s", g_args.challenges_path));
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line[0] != '#') {
+                challenges.push_back(uint256S(line));
+            }
+        }
+        return challenges;
+    }
+    for (int i = 0; i < g_args.num_challenges; ++i) {
+        challenges.push_back(chiapos::MakeUint256(MakeRandomBytes(rng, 32)));
+    }
+    return challenges;
+}
+
+int Run() {
+    std::mt19937_64 rng(std::random_device{}());
+    if (!g_args.create_k_list.empty()) {
+        fs::create_directories(g_args.plots_dir);
+        fs::create_directories(g_args.tmp_dir);
+        for (int k : g_args.create_k_list) {
+            for (int i = 0; i < g_args.plots_per_k; ++i) {
+                CreatePlot(rng, static_cast<uint8_t>(k), g_args.tmp_dir, g_args.plots_dir);
+            }
+        }
+    }
+    chiapos::InitDecompressorQueueDefault(g_args.no_cuda, g_args.max_compression_level);
+    chiapos::SetMaxOpenedPlots(g_args.max_opened_plots);
+
+    Stage stage_load("load-plots");
+    Prover prover = stage_load.Measure([]() { return Prover({Path(g_args.plots_dir)}, {}); });
+    if (prover.GetNumOfPlots() == 0) {
+        PLOGE << "no plot can be found from dir: " << g_args.plots_dir;
+        return 1;
+    }
+    auto challenges = LoadChallenges(rng);
+    PLOGI << tinyformat::format("replaying %d challenge(s) on %d plot(s), filter_bits=%d", challenges.size(),
+                                prover.GetNumOfPlots(), g_args.filter_bits);
+
+    Stage stage_qualities("qualities");
+    Stage stage_best_proof("best-pos-proof");
+    Stage stage_verify("verify-pos");
+    int num_qualities{0}, num_proofs{0}, num_invalid{0};
+    auto start = Clock::now();
+    for (auto const& challenge : challenges) {
+        auto qualities = stage_qualities.Measure(
+                [&prover, &challenge]() { return prover.GetQualityStrings(challenge, g_args.filter_bits); });
+        num_qualities += qualities.size();
+        chiapos::PubKey farmer_pk;
+        auto proof = stage_best_proof.Measure([&prover, &challenge, &farmer_pk]() {
+            auto ticket = chiapos::BeginProving(std::chrono::seconds(g_args.proving_budget_seconds));
+            return pos::QueryBestPosProof(prover, challenge, g_args.difficulty, g_args.dcf_bits, g_args.filter_bits,
+                                          g_args.base_iters, g_args.proof_candidates, ticket, farmer_pk);
+        });
+        if (!proof.has_value()) {
+            continue;
+        }
+        ++num_proofs;
+        bool verified = stage_verify.Measure([&proof, &challenge, &farmer_pk]() {
+            return chiapos::VerifyPos(challenge, proof->local_pk, farmer_pk, proof->pool_pk_or_hash, proof->k,
+                                      proof->proof, nullptr, g_args.filter_bits);
+        });
+        if (!verified) {
+            ++num_invalid;
+        }
+    }
+    double total_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << tinyformat::format(
+            "\nplots=%d, disks=%d, challenges=%d, qualities=%d, proofs=%d, invalid=%d, total=%.3fs "
+            "(throughput %.1f challenges/s)\n",
+            prover.GetNumOfPlots(), prover.GetNumOfDisks(), challenges.size(), num_qualities, num_proofs, num_invalid,
+            total_seconds, total_seconds > 0 ? challenges.size() / total_seconds : 0.0);
+    stage_load.Report();
+    stage_qualities.Report();
+    stage_best_proof.Report();
+    stage_verify.Report();
+    return num_invalid == 0 ? 0 : 1;
+}
+
+}  // namespace bench
+}  // namespace miner
+
+int main(int argc, char** argv) {
+    plog::ConsoleAppender<plog::TxtFormatter> console_appender;
+
+    cxxopts::Options opts("depinc-miner-bench", "Benchmark the PoS lookup pipeline of depinc-miner");
+    opts.add_options()                        // All options
+            ("h,help", "Show help document")  // --help
+            ("v,verbose", "Show debug logs")  // --verbose
+            ("plots-dir", "The dir to load plots from, the created plots are also saved here",
+             cxxopts::value<std::string>()->default_value("bench-plots"))  // --plots-dir
+            ("tmp-dir", "The temporary dir for plotting",
+             cxxopts::value<std::string>()->default_value("bench-tmp"))  // --tmp-dir
+            ("create", "Create plots with the k list before running, e.g. 18,19,20 (18..25)",
+             cxxopts::value<std::vector<int>>())  // --create
+            ("plots-per-k", "How many plots are created for each k",
+             cxxopts::value<int>()->default_value("1"))  // --plots-per-k
+            ("challenges", "The file contains challenges to replay, one hex string per line",
+             cxxopts::value<std::string>()->default_value(""))  // --challenges
+            ("num-challenges", "How many random challenges are replayed when no challenge file is provided",
+             cxxopts::value<int>()->default_value("100"))  // --num-challenges
+            ("filter-bits", "Bits of the plot filter, 0 to look up all plots",
+             cxxopts::value<int>()->default_value("0"))  // --filter-bits
+            ("difficulty", "Difficulty to calculate iters",
+             cxxopts::value<uint64_t>()->default_value("1"))  // --difficulty
+            ("dcf-bits", "Difficulty constant factor bits",
+             cxxopts::value<int>()->default_value(std::to_string(chiapos::DIFFICULTY_CONSTANT_FACTOR_BITS)))  // --dcf-bits
+            ("base-iters", "Base iters", cxxopts::value<int>()->default_value("0"))  // --base-iters
+            ("proof-candidates", "How many best proofs are fetched at the same time",
+             cxxopts::value<int>()->default_value("1"))  // --proof-candidates
+            ("no-cuda", "Do not use GPU to decompress", cxxopts::value<bool>()->default_value("0"))  // --no-cuda
+            ("max-compression-level", "The number of the level to support the max compression",
+             cxxopts::value<int>()->default_value("9"))  // --max-compression-level
+            ("max-opened-plots", "Keep at most this number of plots opened, 0 to keep all plots opened",
+             cxxopts::value<int>()->default_value("0"))  // --max-opened-plots
+            ("proving-budget", "The decompression jobs of a challenge are dropped after this number of seconds",
+             cxxopts::value<int>()->default_value("30"))  // --proving-budget
+            ;
+    cxxopts::ParseResult result = opts.parse(argc, argv);
+    if (result["help"].as<bool>()) {
+        std::cout << opts.help() << std::endl;
+        return 0;
+    }
+    plog::init((result["verbose"].as<bool>() ? plog::debug : plog::info), &console_appender);
+
+    miner::bench::g_args.plots_dir = result["plots-dir"].as<std::string>();
+    miner::bench::g_args.tmp_dir = result["tmp-dir"].as<std::string>();
+    if (result.count("create")) {
+        miner::bench::g_args.create_k_list = result["create"].as<std::vector<int>>();
+    }
+    miner::bench::g_args.plots_per_k = result["plots-per-k"].as<int>();
+    miner::bench::g_args.challenges_path = result["challenges"].as<std::string>();
+    miner::bench::g_args.num_challenges = result["num-challenges"].as<int>();
+    miner::bench::g_args.filter_bits = result["filter-bits"].as<int>();
+    miner::bench::g_args.difficulty = result["difficulty"].as<uint64_t>();
+    miner::bench::g_args.dcf_bits = result["dcf-bits"].as<int>();
+    miner::bench::g_args.base_iters = result["base-iters"].as<int>();
+    miner::bench::g_args.proof_candidates = std::max(result["proof-candidates"].as<int>(), 1);
+    miner::bench::g_args.no_cuda = result["no-cuda"].as<bool>();
+    miner::bench::g_args.max_compression_level = result["max-compression-level"].as<int>();
+    miner::bench::g_args.max_opened_plots = std::max(result["max-opened-plots"].as<int>(), 0);
+    miner::bench::g_args.proving_budget_seconds = std::max(result["proving-budget"].as<int>(), 1);
+    for (int k : miner::bench::g_args.create_k_list) {
+        if (k < 18 || k > 25) {
+            std::cerr << "k=" << k << " is out of range, only 18..25 are supported by the benchmark" << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        return miner::bench::Run();
+    } catch (std::exception const& e) {
+        PLOGE << "error: " << e.what();
+        return 1;
+    }
+}
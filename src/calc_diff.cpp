@@ -14,7 +14,13 @@ namespace chiapos {
 namespace {
 
 arith_uint256 lower_bits(uint256 const& quality_string, int bits) {
-    return UintToArith256(quality_string) & (Pow2(bits) - 1);
+    // The lower bits are read from the bytes directly, no need to convert the whole number
+    assert(bits <= 64);
+    uint64_t val = quality_string.GetUint64(0);
+    if (bits < 64) {
+        val &= (static_cast<uint64_t>(1) << bits) - 1;
+    }
+    return arith_uint256(val);
 }
 
 }  // namespace
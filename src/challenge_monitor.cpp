@@ -0,0 +1,195 @@
+#include "challenge_monitor.h"
+
+#include <plog/Log.h>
+
+#include <algorithm>
+
+namespace miner {
+
+namespace {
+
+bool IsSameVdfProofs(std::vector<RPCClient::VdfProof> const& lhs, std::vector<RPCClient::VdfProof> const& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].challenge != rhs[i].challenge || lhs[i].iters != rhs[i].iters) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// The challenge is polled with the min interval from this long before the expected change
+auto const EXPECTED_UPDATE_LEAD = std::chrono::seconds(2);
+
+}  // namespace
+
+ChallengeMonitor::ChallengeMonitor(RPCClient& client, std::chrono::milliseconds min_interval,
+                                   std::chrono::milliseconds max_interval)
+        : m_client(client), m_min_interval(min_interval), m_max_interval(std::max(min_interval, max_interval)) {}
+
+ChallengeMonitor::~ChallengeMonitor() { Stop(); }
+
+void ChallengeMonitor::Start() {
+    if (m_running.exchange(true)) {
+        return;
+    }
+    m_thread = std::thread(&ChallengeMonitor::MonitorProc, this);
+}
+
+void ChallengeMonitor::Stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lg(m_mtx);
+        m_wakeup = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+void ChallengeMonitor::Notify() {
+    {
+        std::lock_guard<std::mutex> lg(m_mtx);
+        ++m_snapshot.version;
+    }
+    m_cv.notify_all();
+}
+
+void ChallengeMonitor::RequestPoll() {
+    {
+        std::lock_guard<std::mutex> lg(m_mtx);
+        m_wakeup = true;
+    }
+    m_cv.notify_all();
+}
+
+ChallengeMonitor::Snapshot ChallengeMonitor::GetSnapshot() const {
+    std::lock_guard<std::mutex> lg(m_mtx);
+    return m_snapshot;
+}
+
+ChallengeMonitor::Snapshot ChallengeMonitor::WaitForUpdate(uint64_t version, std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_cv.wait_for(lock, timeout, [this, version]() { return m_snapshot.version != version; });
+    return m_snapshot;
+}
+
+void ChallengeMonitor::WatchChallenge(uint256 const& challenge, std::function<void()> on_changed) {
+    {
+        std::lock_guard<std::mutex> lg(m_mtx);
+        m_watched_challenge = challenge;
+        m_on_changed = std::move(on_changed);
+        m_wakeup = true;
+    }
+    m_cv.notify_all();
+}
+
+void ChallengeMonitor::UnwatchChallenge() {
+    std::lock_guard<std::mutex> lg(m_mtx);
+    m_on_changed = nullptr;
+}
+
+void ChallengeMonitor::ExpectUpdate(Clock::time_point expected_at) {
+    {
+        std::lock_guard<std::mutex> lg(m_mtx);
+        if (expected_at >= m_expected_at) {
+            return;
+        }
+        m_expected_at = expected_at;
+    }
+    // the monitor might be waiting for the backed off interval
+    m_cv.notify_all();
+}
+
+void ChallengeMonitor::ClearExpectedUpdate() {
+    std::lock_guard<std::mutex> lg(m_mtx);
+    m_expected_at = Clock::time_point::max();
+}
+
+void ChallengeMonitor::MonitorProc() {
+    auto interval = m_min_interval;
+    bool requested{false};
+    while (m_running) {
+        if (Poll(requested)) {
+            interval = m_min_interval;
+        } else {
+            interval = std::min(interval * 2, m_max_interval);
+        }
+        std::unique_lock<std::mutex> lock(m_mtx);
+        // Poll with the min interval around the expected change, don't sleep past the start of it
+        auto wait_until = Clock::now() + interval;
+        auto expected_at = m_expected_at;
+        if (expected_at != Clock::time_point::max()) {
+            auto fast_from = expected_at - EXPECTED_UPDATE_LEAD;
+            if (Clock::now() >= fast_from) {
+                interval = m_min_interval;
+                wait_until = Clock::now() + interval;
+            } else {
+                wait_until = std::min(wait_until, fast_from);
+            }
+        }
+        m_cv.wait_until(lock, wait_until, [this, expected_at]() { return m_wakeup || m_expected_at != expected_at; });
+        requested = m_wakeup;
+        if (m_wakeup) {
+            m_wakeup = false;
+            interval = m_min_interval;
+        }
+    }
+}
+
+bool ChallengeMonitor::Poll(bool requested) {
+    RPCClient::Challenge challenge;
+    std::string error_msg;
+    try {
+        challenge = m_client.QueryChallenge();
+    } catch (RPCError const& e) {
+        // the node is busy, try again later
+        PLOGD << "querychallenge returns an error: " << e.what();
+        return false;
+    } catch (std::exception const& e) {
+        error_msg = e.what();
+    }
+    bool changed;
+    std::function<void()> on_changed;
+    {
+        std::lock_guard<std::mutex> lg(m_mtx);
+        m_snapshot.updated_at = Clock::now();
+        if (!error_msg.empty()) {
+            changed = !m_snapshot.error;
+            m_snapshot.error = true;
+            m_snapshot.error_msg = std::move(error_msg);
+        } else {
+            changed = m_snapshot.error || !m_snapshot.available ||
+                      m_snapshot.challenge.challenge != challenge.challenge ||
+                      !IsSameVdfProofs(m_snapshot.challenge.vdf_proofs, challenge.vdf_proofs);
+            uint256 challenge_before = m_snapshot.challenge.challenge;
+            m_snapshot.available = true;
+            m_snapshot.error = false;
+            m_snapshot.error_msg.clear();
+            m_snapshot.challenge = std::move(challenge);
+            if (changed && m_snapshot.challenge.challenge != challenge_before) {
+                // the expected change might be done, go back to the adaptive interval
+                m_expected_at = Clock::time_point::max();
+            }
+            if (m_on_changed && m_snapshot.challenge.challenge != m_watched_challenge) {
+                on_changed = std::move(m_on_changed);
+                m_on_changed = nullptr;
+            }
+        }
+        if (changed || requested) {
+            ++m_snapshot.version;
+        }
+    }
+    if (changed || requested) {
+        m_cv.notify_all();
+    }
+    if (on_changed) {
+        on_changed();
+    }
+    return changed;
+}
+
+}  // namespace miner
@@ -0,0 +1,112 @@
+#ifndef DEPINC_MINER_CHALLENGE_MONITOR_H
+#define DEPINC_MINER_CHALLENGE_MONITOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "rpc_client.h"
+
+namespace miner {
+
+/**
+ * @brief Watches the challenge and the VDF proofs from the node on a background thread, the waiters are woken up
+ * when anything is changed
+ *
+ * The node doesn't provide a way to push the changes, so the challenge is polled with an adaptive interval, it starts
+ * from the min interval after each change and it is doubled on each unchanged poll until it reaches the max interval.
+ * The interval is only held at the min interval around the time a change is expected (see `ExpectUpdate`), e.g. when
+ * the VDF of the challenge should be done. The version of the snapshot is only increased when the snapshot is changed,
+ * a poll asked by `RequestPoll()` is done, or `Notify()` is called by a local event source (e.g. the timelord client)
+ * to wake up the waiters.
+ */
+class ChallengeMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Snapshot {
+        uint64_t version{0};
+        Clock::time_point updated_at;
+        bool available{false};  // `challenge` is valid
+        bool error{false};      // the last query to the node failed, `error_msg` is the reason
+        std::string error_msg;
+        RPCClient::Challenge challenge;
+    };
+
+    ChallengeMonitor(RPCClient& client, std::chrono::milliseconds min_interval, std::chrono::milliseconds max_interval);
+
+    ~ChallengeMonitor();
+
+    void Start();
+
+    void Stop();
+
+    /// Wake up the waiters, the node isn't queried
+    void Notify();
+
+    /// Query the challenge immediately, the waiters are woken up after the poll even if nothing is changed
+    void RequestPoll();
+
+    Snapshot GetSnapshot() const;
+
+    /**
+     * @brief Wait until the snapshot is newer than the version
+     *
+     * @param version The version of the snapshot the caller has already seen
+     * @param timeout Returns the current snapshot when nothing is changed after the timeout
+     */
+    Snapshot WaitForUpdate(uint64_t version, std::chrono::milliseconds timeout) const;
+
+    /**
+     * @brief Call the handler once on the monitor thread when another challenge is seen, it replaces the challenge
+     * watched before, the challenge is polled once immediately and then with the adaptive interval
+     */
+    void WatchChallenge(uint256 const& challenge, std::function<void()> on_changed);
+
+    void UnwatchChallenge();
+
+    /**
+     * @brief A change is expected at the time point, the challenge is polled with the min interval from a little
+     * before it until the challenge is changed
+     *
+     * The earlier time point is kept when a change is already expected, so an overdue change stays expected.
+     */
+    void ExpectUpdate(Clock::time_point expected_at);
+
+    /// No change is expected, the challenge is polled with the adaptive interval
+    void ClearExpectedUpdate();
+
+private:
+    void MonitorProc();
+
+    /**
+     * @brief Query the challenge from the node
+     *
+     * @param requested The poll is asked by `Notify()`, the waiters are woken up even if nothing is changed
+     *
+     * @return true when the snapshot is changed
+     */
+    bool Poll(bool requested);
+
+    RPCClient& m_client;
+    std::chrono::milliseconds m_min_interval;
+    std::chrono::milliseconds m_max_interval;
+    mutable std::mutex m_mtx;
+    mutable std::condition_variable m_cv;
+    Snapshot m_snapshot;
+    bool m_wakeup{false};
+    Clock::time_point m_expected_at{Clock::time_point::max()};
+    uint256 m_watched_challenge;
+    std::function<void()> m_on_changed;  // empty when no challenge is watched
+    std::atomic_bool m_running{false};
+    std::thread m_thread;
+};
+
+}  // namespace miner
+
+#endif
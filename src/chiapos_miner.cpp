@@ -15,10 +15,12 @@
 
 #include <rpc_client.h>
 
+#include <algorithm>
 #include <atomic>
 #include <asio.hpp>
 #include <chrono>
 #include <cstdint>
+#include <future>
 #include <mutex>
 #include <thread>
 #include <tuple>
@@ -32,50 +34,6 @@
 namespace miner {
 namespace pos {
 
-bool IsZeroBytes(Bytes const& bytes) {
-    for (uint8_t byte : bytes) {
-        if (byte != 0) {
-            return false;
-        }
-    }
-    return true;
-}
-
-chiapos::QualityStringPack QueryTheBestQualityString(std::vector<chiapos::QualityStringPack> const& qs_pack_vec,
-                                                     uint256 const& challenge, uint64_t difficulty, int bits_filter,
-                                                     int difficulty_constant_factor_bits, int base_iters) {
-    assert(!qs_pack_vec.empty());
-    chiapos::QualityStringPack res;
-    int64_t best_iters{-1};
-    double best_quality_in_plot;
-    arith_uint256 best_quality;
-    for (chiapos::QualityStringPack const& qs_pack : qs_pack_vec) {
-        Bytes quality_string = qs_pack.quality_str.ToBytes();
-        assert(!IsZeroBytes(quality_string));
-        uint256 mixed_quality_string = chiapos::GetMixedQualityString(quality_string, challenge);
-        double quality_in_plot;
-        arith_uint256 quality;
-        uint64_t iters = chiapos::CalculateIterationsQuality(mixed_quality_string, difficulty, bits_filter,
-                                                             difficulty_constant_factor_bits, qs_pack.k, base_iters,
-                                                             &quality_in_plot, &quality);
-        PLOGD << tinyformat::format("checking pos, quality_in_plot=%1.3f, quality=%e, iters=%lld, k=%d",
-                                    quality_in_plot, quality.getdouble(), chiapos::MakeNumberStr(iters),
-                                    (int)qs_pack.k);
-        if (best_iters == -1 || iters < best_iters) {
-            res = qs_pack;
-            best_iters = static_cast<int64_t>(iters);
-            best_quality_in_plot = quality_in_plot;
-            best_quality = quality;
-        }
-    }
-    if (best_iters != -1) {
-        PLOGI << tinyformat::format("Best proof is queried, quality_in_plot=%1.3f, quality=%e, iters=%lld, k=%d",
-                                    best_quality_in_plot, best_quality.getdouble(), chiapos::MakeNumberStr(best_iters),
-                                    res.k);
-    }
-    return res;
-}
-
 template <typename Stream>
 Stream& operator<<(Stream& os, RPCClient::PosProof const& proof)
 {
@@ -86,81 +44,209 @@ Stream& operator<<(Stream& os, RPCClient::PosProof const& proof)
     os << "plot_id: " << proof.plot_id.GetHex() << '\n';
     os << "pool_pk_or_hash (type=" << chiapos::TypeToString(chiapos::GetType(proof.pool_pk_or_hash)) << "): "
         << chiapos::BytesToHex(chiapos::ToBytes(proof.pool_pk_or_hash)) << '\n';
-    os << "local_pk: " << chiapos::BytesToHex(chiapos::MakeBytes(proof.local_pk)) << '\n';
+    os << "local_pk: " << chiapos::BytesToHex(proof.local_pk) << '\n';
     os << "proof: " << chiapos::BytesToHex(proof.proof) << '\n';
     return os;
 }
 
-chiapos::optional<RPCClient::PosProof> QueryBestPosProof(Prover& prover, uint256 const& challenge, uint64_t difficulty,
-                                                         int difficulty_constant_factor_bits, int bits_filter,
-                                                         int base_iters, chiapos::PubKey& out_farmer_pk,
-                                                         std::string* out_plot_path) {
-    auto qs_pack_vec = prover.GetQualityStrings(challenge, bits_filter);
-    PLOG_INFO << "total " << qs_pack_vec.size() << " answer(s), filter_bits=" << bits_filter;
-    if (qs_pack_vec.empty()) {
-        // No prove can pass the filter
-        return {};
-    }
-    chiapos::QualityStringPack qs_pack = QueryTheBestQualityString(qs_pack_vec, challenge, difficulty, bits_filter,
-                                                                   difficulty_constant_factor_bits, base_iters);
-    Bytes quality_string = qs_pack.quality_str.ToBytes();
-    uint256 mixed_quality_string = chiapos::GetMixedQualityString(quality_string, challenge);
-    if (out_plot_path) {
-        *out_plot_path = qs_pack.plot_path;
-    }
+/// The full proofs of the candidates are fetched by at most this number of threads
+static int const MAX_FETCH_THREADS = 4;
+
+struct FullProofResult {
+    RPCClient::PosProof proof;
+    chiapos::PubKey farmer_pk;
+    std::string plot_path;
+    bool verified{false};
+};
+
+/// Read the full proof of the candidate from the plot and verify it, returns empty when the proof cannot be read
+chiapos::optional<FullProofResult> FetchFullProof(QualityCandidate const& candidate, uint256 const& challenge,
+                                                  int bits_filter, chiapos::ProvingTicket const& ticket) {
+    chiapos::CPlotFile const& plot_file = candidate.plot_file;
+    FullProofResult res;
+    res.plot_path = plot_file.GetPath();
     chiapos::PlotMemo memo;
-    if (!Prover::ReadPlotMemo(qs_pack.plot_path, memo)) {
+    if (!plot_file.ReadMemo(memo)) {
         return {};
     }
-    RPCClient::PosProof proof;
-    proof.mixed_quality_string = mixed_quality_string;
-    proof.iters = chiapos::CalculateIterationsQuality(mixed_quality_string, difficulty, bits_filter,
-                                                      difficulty_constant_factor_bits, qs_pack.k, base_iters);
+    RPCClient::PosProof& proof = res.proof;
+    proof.mixed_quality_string = candidate.mixed_quality_string;
+    proof.iters = candidate.iters;
     proof.challenge = challenge;
-    proof.k = qs_pack.k;
+    proof.k = plot_file.GetK();
     proof.plot_id = chiapos::MakeUint256(memo.plot_id);
     proof.pool_pk_or_hash = chiapos::MakePubKeyOrHash(memo.plot_id_type, memo.pool_pk_or_puzzle_hash);
     proof.local_pk = chiapos::MakeArray<chiapos::PK_LEN>(Prover::CalculateLocalPkBytes(memo.local_master_sk));
-    if (!Prover::QueryFullProof(qs_pack.plot_path, challenge, qs_pack.index, proof.proof, out_farmer_pk)) {
+    res.farmer_pk = chiapos::MakeArray<chiapos::PK_LEN>(memo.farmer_pk);
+    if (plot_file.GetCompressionLevel() > 0) {
+        // The full proof is decompressed before the quality jobs, the job might be dropped on a new challenge
+        auto full_proof = plot_file.AsyncGetFullProof(challenge, candidate.index, ticket).get();
+        if (!full_proof.has_value()) {
+            return {};
+        }
+        proof.proof = std::move(*full_proof);
+    } else if (!plot_file.GetFullProof(challenge, candidate.index, proof.proof)) {
         return {};
     }
     PLOGI << "iters=" << chiapos::FormatNumberStr(std::to_string(proof.iters)) << ", k=" << (int)proof.k
           << ", farmer-pk: " << chiapos::BytesToHex(memo.farmer_pk);
-    bool verified = chiapos::VerifyPos(challenge, proof.local_pk, chiapos::MakeArray<chiapos::PK_LEN>(memo.farmer_pk),
-                                       proof.pool_pk_or_hash, proof.k, proof.proof, nullptr, bits_filter);
-    if (!verified) {
-        std::cout << proof << '\n';
+    res.verified = chiapos::VerifyPos(challenge, proof.local_pk, res.farmer_pk, proof.pool_pk_or_hash, proof.k,
+                                      proof.proof, nullptr, bits_filter);
+    if (!res.verified) {
+        PLOGE << "The pos answer cannot be verified, plot: " << res.plot_path << ", proof: " << proof;
+    }
+    return res;
+}
+
+chiapos::optional<RPCClient::PosProof> QueryBestPosProof(Prover& prover, uint256 const& challenge, uint64_t difficulty,
+                                                         int difficulty_constant_factor_bits, int bits_filter,
+                                                         int base_iters, int num_candidates,
+                                                         chiapos::ProvingTicket const& ticket,
+                                                         chiapos::PubKey& out_farmer_pk, std::string* out_plot_path) {
+    int num_qualities;
+    auto candidates = prover.QueryBestQualities(challenge, bits_filter, difficulty, difficulty_constant_factor_bits,
+                                                base_iters, std::max(num_candidates, 1), ticket, &num_qualities);
+    PLOG_INFO << "total " << num_qualities << " answer(s), filter_bits=" << bits_filter;
+    if (ticket.IsCancelled()) {
+        PLOGI << "the proving is cancelled, challenge: " << challenge.GetHex();
+        return {};
+    }
+    if (candidates.empty()) {
+        // No prove can pass the filter
+        return {};
+    }
+    PLOGI << tinyformat::format("Best proof is queried, iters=%lld, k=%d, total %d candidate(s)",
+                                chiapos::MakeNumberStr(candidates.front().iters),
+                                (int)candidates.front().plot_file.GetK(), candidates.size());
+    // Fetch the full proofs on a few threads by the order of iters, the first valid one is taken. Each fetch has its
+    // own ticket, the others are cancelled then, a fetch which isn't started yet or is still queued in the proving
+    // scheduler is dropped
+    std::vector<chiapos::ProvingTicket> fetch_tickets;
+    std::vector<std::promise<chiapos::optional<FullProofResult>>> promises(candidates.size());
+    std::vector<std::future<chiapos::optional<FullProofResult>>> fetches;
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        fetch_tickets.push_back(ticket.MakeChild());
+        fetches.push_back(promises[i].get_future());
+    }
+    std::atomic<std::size_t> next_fetch{0};
+    auto fetch_proc = [&]() {
+        for (std::size_t i = next_fetch++; i < candidates.size(); i = next_fetch++) {
+            try {
+                if (fetch_tickets[i].IsCancelled()) {
+                    promises[i].set_value({});
+                    continue;
+                }
+                promises[i].set_value(FetchFullProof(candidates[i], challenge, bits_filter, fetch_tickets[i]));
+            } catch (...) {
+                promises[i].set_exception(std::current_exception());
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    if (candidates.size() == 1) {
+        fetch_proc();
+    } else {
+        int num_threads = std::min(static_cast<int>(candidates.size()), MAX_FETCH_THREADS);
+        for (int i = 0; i < num_threads; ++i) {
+            threads.emplace_back(fetch_proc);
+        }
+    }
+    chiapos::optional<FullProofResult> best;
+    bool unverified{false};
+    for (auto& fetch : fetches) {
+        chiapos::optional<FullProofResult> res;
+        try {
+            res = fetch.get();
+        } catch (std::exception const& e) {
+            PLOGE << "cannot fetch full proof: " << e.what();
+            continue;
+        }
+        if (!res.has_value()) {
+            continue;
+        }
+        if (!res->verified) {
+            unverified = true;
+            continue;
+        }
+        best = std::move(res);
+        break;
+    }
+    // The threads use the candidates and the plots, they are joined before leaving
+    for (auto const& fetch_ticket : fetch_tickets) {
+        fetch_ticket.Cancel();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (best.has_value()) {
+        out_farmer_pk = best->farmer_pk;
+        if (out_plot_path) {
+            *out_plot_path = best->plot_path;
+        }
+        return best->proof;
+    }
+    if (unverified) {
         throw std::runtime_error("The pos answer cannot be verified");
     }
-    assert(verified);
-    return proof;
+    return {};
 }
 
 }  // namespace pos
 
 static int const CHECKING_VDF_INTERVAL_SECS = 22;
+/// A connection which lasts longer than this resets the reconnection backoff, it is longer than the PING interval
+static int const STABLE_CONNECTION_SECS = 90;
+/// A timelord whose health score is lower than this ratio of the best score gets the CALC later
+static double const UNHEALTHY_SCORE_RATIO = 0.5;
+static int const DEFERRED_CALC_SECS = 3;
+static int const CHALLENGE_MIN_POLLING_MILLIS = 200;
+static int const CHALLENGE_MAX_POLLING_MILLIS = 1600;
+static int const MAX_PROOF_CHALLENGES = 16;
 
 Miner::Miner(RPCClient& client, Prover& prover, std::map<chiapos::PubKey, chiapos::SecreKey> secre_keys,
-             std::string reward_dest, int difficulty_constant_factor_bits, bool no_cuda, int max_compression_level, int timeout_seconds)
+             std::string reward_dest, int difficulty_constant_factor_bits, bool no_cuda, int max_compression_level, int timeout_seconds,
+             CpuLayout cpu_layout, int num_proof_candidates)
         : m_client(client),
           m_prover(prover),
           m_secre_keys(secre_keys),
           m_reward_dest(std::move(reward_dest)),
-          m_difficulty_constant_factor_bits(difficulty_constant_factor_bits)
+          m_difficulty_constant_factor_bits(difficulty_constant_factor_bits),
+          m_num_proof_candidates(num_proof_candidates),
+          m_cpu_layout(std::move(cpu_layout)),
+          m_challenge_monitor(client, std::chrono::milliseconds(CHALLENGE_MIN_POLLING_MILLIS),
+                              std::chrono::milliseconds(CHALLENGE_MAX_POLLING_MILLIS)),
+          m_proof_submitter(client),
+          m_proof_store(MAX_PROOF_CHALLENGES)
 {
+    // The next challenge is expected soon after a proof is accepted, otherwise the miner tries the challenge again
+    m_proof_submitter.SetSubmittedHandler([this](uint256 const&, bool) { m_challenge_monitor.Notify(); });
     // Initialize decompressor
-    chiapos::InitDecompressorQueueDefault(no_cuda, max_compression_level, timeout_seconds);
+    chiapos::InitDecompressorQueueDefault(no_cuda, max_compression_level, timeout_seconds, m_cpu_layout.num_contexts,
+                                          m_cpu_layout.threads_per_context, m_cpu_layout.cpu_affinity);
 }
 
 Miner::~Miner() {
+    m_proof_submitter.Stop();
+    m_challenge_monitor.Stop();
     if (m_pthread_timelord) {
         PLOGI << "exiting timelord client...";
         m_shutting_down = true;
-        for (auto desc : m_timelords) {
-            if (desc.second.pclient) {
-                desc.second.pclient->Exit();
+        // the clients and the timers belong to the timelord thread
+        asio::post(m_ioc, [this]() {
+            for (auto const& desc : m_timelords) {
+                if (desc.second.pclient) {
+                    desc.second.pclient->Exit();
+                }
+                if (desc.second.ptimer_reconnect) {
+                    asio::error_code ignored_ec;
+                    desc.second.ptimer_reconnect->cancel(ignored_ec);
+                }
             }
-        }
+            if (m_ptimer_deferred_calc) {
+                asio::error_code ignored_ec;
+                m_ptimer_deferred_calc->cancel(ignored_ec);
+            }
+        });
         m_pthread_timelord->join();
     }
 }
@@ -181,6 +267,7 @@ void Miner::StartTimelord(std::vector<std::string> const& endpoints, uint16_t de
         std::map<EndpointDesc, ClientDesc>::iterator it;
         std::tie(it, std::ignore) = m_timelords.insert(std::make_pair(EndpointDesc{hostname, port}, ClientDesc{}));
         it->second.reconnecting = false;
+        it->second.pstats = std::make_shared<TimelordStats>();
         it->second.pclient = PrepareTimelordClient(hostname, port);
     }
     m_pthread_timelord.reset(new std::thread(std::bind(&Miner::TimelordProc, this)));
@@ -195,9 +282,17 @@ int Miner::Run() {
     uint64_t vdf_speed{100000};
     chiapos::PubKey farmer_pk;
     chiapos::SecreKey farmer_sk;
+    if (m_cpu_layout.cpu_affinity && !m_cpu_layout.reserved_cpus.empty()) {
+        // The state machine runs on the reserved cores, the decompressor threads don't compete with it
+        if (!PinCurrentThread(m_cpu_layout.reserved_cpus)) {
+            PLOGW << "cannot pin the miner thread to the reserved cores";
+        }
+    }
+    m_challenge_monitor.Start();
+    m_proof_submitter.Start();
+    uint256 last_challenge;
     while (1) {
         try {
-            std::this_thread::yield();
             PLOG_INFO << "==== Status: " << ToString(m_state) << " ====";
             if (m_state == State::RequireChallenge) {
                 if (!m_client.CheckChiapos()) {
@@ -207,15 +302,31 @@ int Miner::Run() {
                 }
                 PLOG_INFO << "chia pos is ready";
                 // Reset variables
+                m_challenge_monitor.ClearExpectedUpdate();
                 pos.reset();
                 vdf.reset();
                 m_current_challenge.SetNull();
                 m_current_iters = 0;
-                // Query challenge
-                queried_challenge = m_client.QueryChallenge();
-                if (m_submit_history.find(queried_challenge.challenge) != std::end(m_submit_history)) {
+                // Take the challenge which is already queried by the monitor when it is a new one, otherwise query it
+                auto prefetched = m_challenge_monitor.GetSnapshot();
+                if (prefetched.available && !prefetched.error && prefetched.challenge.challenge != last_challenge) {
+                    queried_challenge = std::move(prefetched.challenge);
+                } else {
+                    queried_challenge = m_client.QueryChallenge();
+                }
+                last_challenge = queried_challenge.challenge;
+                if (m_proof_submitter.IsSubmitted(queried_challenge.challenge)) {
                     PLOG_INFO << "proof is already submitted, waiting for next challenge...";
-                    std::this_thread::sleep_for(std::chrono::seconds(1));
+                    // our block should be seen soon
+                    m_challenge_monitor.ExpectUpdate(ChallengeMonitor::Clock::now());
+                    auto snapshot = m_challenge_monitor.GetSnapshot();
+                    while (m_proof_submitter.IsSubmitted(queried_challenge.challenge) &&
+                           (!snapshot.available || snapshot.challenge.challenge == queried_challenge.challenge)) {
+                        snapshot = m_challenge_monitor.WaitForUpdate(snapshot.version, std::chrono::seconds(3));
+                        if (snapshot.error) {
+                            break;
+                        }
+                    }
                 } else {
                     m_current_challenge = queried_challenge.challenge;
                     PLOG_INFO << "challenge is ready: " << m_current_challenge.GetHex()
@@ -229,9 +340,20 @@ int Miner::Run() {
                 PLOG_INFO << "finding PoS for challenge: " << m_current_challenge.GetHex()
                           << ", dcf_bits: " << m_difficulty_constant_factor_bits
                           << ", filter_bits: " << queried_challenge.filter_bits;
+                // The decompression jobs of the previous challenge are dropped, the new ones must be done in time
+                auto ticket = chiapos::BeginProving(std::chrono::seconds(queried_challenge.target_duration));
+                // The search is cancelled as soon as the monitor sees a new challenge
+                m_challenge_monitor.WatchChallenge(m_current_challenge, [ticket]() { ticket.Cancel(); });
                 pos = pos::QueryBestPosProof(m_prover, m_current_challenge, queried_challenge.difficulty,
                                              m_difficulty_constant_factor_bits, queried_challenge.filter_bits,
-                                             queried_challenge.base_iters, farmer_pk, &curr_plot_path);
+                                             queried_challenge.base_iters, m_num_proof_candidates, ticket, farmer_pk,
+                                             &curr_plot_path);
+                m_challenge_monitor.UnwatchChallenge();
+                if (ticket.IsCancelled()) {
+                    PLOG_INFO << "!!!!! Challenge is changed while finding PoS !!!!!";
+                    m_state = State::RequireChallenge;
+                    continue;
+                }
                 if (pos.has_value()) {
                     auto it_sk = m_secre_keys.find(farmer_pk);
                     if (it_sk == std::end(m_secre_keys)) {
@@ -240,7 +362,7 @@ int Miner::Run() {
                         PLOGE << tinyformat::format(
                                 "No corresponding secure key can be found for farmer public-key: %s, the related plots "
                                 "are removed, total %d plot(s) remain",
-                                chiapos::BytesToHex(chiapos::MakeBytes(farmer_pk)), m_prover.GetNumOfPlots());
+                                chiapos::BytesToHex(farmer_pk), m_prover.GetNumOfPlots());
                         m_state = State::FindPoS;
                         continue;
                     }
@@ -269,6 +391,9 @@ int Miner::Run() {
             } else if (m_state == State::WaitVDF) {
                 std::string estimate_time_str{"n/a"};
                 int estimate_seconds = static_cast<int>(m_current_iters / vdf_speed);
+                // The node is polled fast only when the VDF should be done, it backs off before that
+                m_challenge_monitor.ExpectUpdate(ChallengeMonitor::Clock::now() +
+                                                 std::chrono::seconds(estimate_seconds));
                 estimate_time_str = tinyformat::format(
                         "%s seconds (%s), vdf speed=%s ips", chiapos::MakeNumberStr(estimate_seconds),
                         chiapos::FormatTime(estimate_seconds), chiapos::MakeNumberStr(vdf_speed));
@@ -317,13 +442,8 @@ int Miner::Run() {
                 pp.vdf = *vdf;
                 pp.farmer_sk = farmer_sk;
                 pp.reward_dest = m_reward_dest;
-                try {
-                    m_client.SubmitProof(pp);
-                    m_submit_history.insert(queried_challenge.challenge);
-                    PLOG_INFO << "$$$$$ Proofs have been submitted $$$$$";
-                } catch (std::exception const& e) {
-                    PLOG_ERROR << "SubmitProof throws an exception: " << e.what();
-                }
+                // The proofs are submitted on the submitter thread, the next challenge is processed meanwhile
+                m_proof_submitter.Submit(queried_challenge.challenge, std::move(pp));
                 m_state = State::RequireChallenge;
             }
         } catch (NetError const& e) {
@@ -348,12 +468,17 @@ TimelordClientPtr Miner::PrepareTimelordClient(std::string const& hostname, unsi
     PLOGI << "Establishing connection to timelord " << hostname << ":" << port;
     auto ptimelord_client = TimelordClient::CreateTimelordClient(m_ioc);
     auto pweak_timelord = std::weak_ptr<TimelordClient>(ptimelord_client);
-    ptimelord_client->SetConnectionHandler([this, pweak_timelord]() {
-        PLOGI << "Connected to timelord";
+    ptimelord_client->SetConnectionHandler([this, hostname, port, pweak_timelord]() {
+        PLOGI << "Connected to timelord " << hostname << ":" << port;
         auto ptimelord_client = pweak_timelord.lock();
         if (ptimelord_client == nullptr) {
             return;
         }
+        auto it = m_timelords.find({hostname, port});
+        assert(it != std::end(m_timelords));
+        it->second.connected = true;
+        it->second.connected_at = std::chrono::steady_clock::now();
+        it->second.pstats->AddConnected();
         if (!m_current_challenge.IsNull()) {
             ptimelord_client->Calc(m_current_challenge, m_current_iters, m_prover.GetGroupHash(),
                                    m_prover.GetTotalSize(), CHECKING_VDF_INTERVAL_SECS);
@@ -378,25 +503,40 @@ TimelordClientPtr Miner::PrepareTimelordClient(std::string const& hostname, unsi
                         return;
                     }
                     it->second.reconnecting = true;
-                    // wait 3 seconds
-                    int const RECONNECT_WAIT_SECONDS = 3;
-                    PLOGI << "Establish connection to timelord after " << RECONNECT_WAIT_SECONDS << " seconds";
+                    it->second.pstats->AddFailure();
+                    // A connection which is lost soon after it is established counts as a failure too, so a flapping
+                    // endpoint keeps backing off
+                    if (it->second.connected && std::chrono::steady_clock::now() - it->second.connected_at >=
+                                                        std::chrono::seconds(STABLE_CONNECTION_SECS)) {
+                        it->second.backoff.Reset();
+                    }
+                    it->second.connected = false;
+                    auto delay = it->second.backoff.Next();
+                    PLOGI << tinyformat::format("Establish connection to timelord %s:%d after %d ms, failures: %d, %s",
+                                                hostname, port, delay.count(), it->second.backoff.GetNumOfFailures(),
+                                                it->second.pstats->ToString());
                     auto ptimer = std::make_shared<asio::steady_timer>(m_ioc);
-                    ptimer->expires_after(std::chrono::seconds(RECONNECT_WAIT_SECONDS));
-                    ptimer->async_wait([this, hostname, port, ptimer](std::error_code const& ec) {
-                        if (ec) {
+                    it->second.ptimer_reconnect = ptimer;
+                    ptimer->expires_after(delay);
+                    ptimer->async_wait([this, hostname, port](std::error_code const& ec) {
+                        if (ec || m_shutting_down) {
                             return;
                         }
                         // ready to connect
                         auto it = m_timelords.find({hostname, port});
                         assert(it != std::end(m_timelords));
                         it->second.reconnecting = false;
+                        it->second.ptimer_reconnect.reset();
                         it->second.pclient = PrepareTimelordClient(hostname, port);
                     });
                 }
             });
-    ptimelord_client->SetProofReceiver(
-            [this](uint256 const& challenge, ProofDetail const& detail) { SaveProof(challenge, detail); });
+    ptimelord_client->SetProofReceiver([this, hostname, port](uint256 const& challenge, ProofDetail const& detail) {
+        SaveProof(EndpointDesc{hostname, port}, challenge, detail);
+    });
+    auto it = m_timelords.find({hostname, port});
+    assert(it != std::end(m_timelords));
+    ptimelord_client->SetStats(it->second.pstats);
     ptimelord_client->Connect(hostname, port);
     return ptimelord_client;
 }
@@ -416,62 +556,59 @@ Miner::BreakReason Miner::CheckAndBreak(std::atomic_bool& running, int timeout_s
     if (m_pthread_timelord) {
         PLOGD << "request proof from timelord";
         asio::post(m_ioc, [this, current_challenge, iters, group_hash, total_size]() {
-            for (auto desc : m_timelords) {
-                if (!desc.second.reconnecting && desc.second.pclient) {
-                    desc.second.pclient->Calc(current_challenge, iters, group_hash, total_size,
-                                              CHECKING_VDF_INTERVAL_SECS);
-                }
-            }
+            SendCalc(current_challenge, iters, group_hash, total_size);
         });
     }
-    auto start_time = std::chrono::system_clock::now();
+    // wake up the monitor, only the snapshots which are queried after this point are trusted
+    auto start_time = ChallengeMonitor::Clock::now();
+    m_challenge_monitor.RequestPoll();
+    uint64_t version = m_challenge_monitor.GetSnapshot().version;
     while (running) {
-        auto curr_time = std::chrono::system_clock::now();
+        auto curr_time = ChallengeMonitor::Clock::now();
         auto curr_seconds = std::chrono::duration_cast<std::chrono::seconds>(curr_time - start_time).count();
         if (curr_seconds >= timeout_seconds) {
             return BreakReason::Timeout;
         }
-        try {
-            // Query current challenge, compare
-            RPCClient::Challenge ch = m_client.QueryChallenge();
-            if (ch.challenge != initial_challenge) {
-                // Challenge is changed
-                return BreakReason::ChallengeIsChanged;
-            }
-            // Find vdf proofs
-            for (auto const& vdf_proof : ch.vdf_proofs) {
-                if (vdf_proof.iters >= iters && vdf_proof.challenge == current_challenge) {
-                    // found
-                    out_vdf = vdf_proof;
-                    return BreakReason::VDFIsAcquired;
-                }
+        // Query proof from timelord if it is created, the monitor is notified when a proof is received
+        if (m_pthread_timelord) {
+            auto detail = QueryProofFromTimelord(current_challenge, iters);
+            if (detail.has_value()) {
+                PLOGI << "queried vdf proof from timelord";
+                RPCClient::VdfProof vdf;
+                vdf.challenge = current_challenge;
+                vdf.y = chiapos::MakeVDFForm(detail->y);
+                vdf.proof = detail->proof;
+                vdf.witness_type = detail->witness_type;
+                vdf.iters = detail->iters;
+                vdf.duration = std::max(detail->duration, 1);
+                out_vdf = vdf;
+                return BreakReason::VDFIsAcquired;
             }
-            // Query proof from timelord if it is created
-            if (m_pthread_timelord) {
-                auto detail = QueryProofFromTimelord(current_challenge, iters);
-                if (detail.has_value()) {
-                    PLOGI << "queried vdf proof from timelord";
-                    RPCClient::VdfProof vdf;
-                    vdf.challenge = current_challenge;
-                    vdf.y = chiapos::MakeVDFForm(detail->y);
-                    vdf.proof = detail->proof;
-                    vdf.witness_type = detail->witness_type;
-                    vdf.iters = detail->iters;
-                    vdf.duration = std::max(detail->duration, 1);
-                    out_vdf = vdf;
-                    return BreakReason::VDFIsAcquired;
-                }
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));
-        } catch (NetError const& e) {
-            PLOGE << "NetError: " << e.what();
-            return BreakReason::Error;
-        } catch (RPCError const& e) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        } catch (std::exception const& e) {
-            PLOGE << "unknown error: " << e.what();
+        }
+        auto snapshot = m_challenge_monitor.WaitForUpdate(version, std::chrono::seconds(1));
+        version = snapshot.version;
+        if (snapshot.updated_at < start_time) {
+            continue;
+        }
+        if (snapshot.error) {
+            PLOGE << "NetError: " << snapshot.error_msg;
             return BreakReason::Error;
         }
+        if (!snapshot.available) {
+            continue;
+        }
+        if (snapshot.challenge.challenge != initial_challenge) {
+            // Challenge is changed
+            return BreakReason::ChallengeIsChanged;
+        }
+        // Find vdf proofs
+        for (auto const& vdf_proof : snapshot.challenge.vdf_proofs) {
+            if (vdf_proof.iters >= iters && vdf_proof.challenge == current_challenge) {
+                // found
+                out_vdf = vdf_proof;
+                return BreakReason::VDFIsAcquired;
+            }
+        }
     }
     return BreakReason::Error;
 }
@@ -492,32 +629,97 @@ std::string Miner::ToString(State state) {
     assert(false);
 }
 
-void Miner::TimelordProc() { m_ioc.run(); }
+void Miner::TimelordProc() {
+    if (m_cpu_layout.cpu_affinity) {
+        PinCurrentThread(m_cpu_layout.reserved_cpus);
+    }
+    m_ioc.run();
+}
 
 chiapos::optional<ProofDetail> Miner::QueryProofFromTimelord(uint256 const& challenge, uint64_t iters) const {
-    std::lock_guard<std::mutex> lg(m_mtx_proofs);
-    auto it = m_proofs.find(challenge);
-    if (it == std::end(m_proofs)) {
-        return {};
+    return m_proof_store.Query(challenge, iters);
+}
+
+void Miner::SendCalc(uint256 const& challenge, uint64_t iters, uint256 const& group_hash, uint64_t total_size) {
+    m_calc_challenge = challenge;
+    m_calc_iters = iters;
+    if (m_ptimer_deferred_calc) {
+        asio::error_code ignored_ec;
+        m_ptimer_deferred_calc->cancel(ignored_ec);
+        m_ptimer_deferred_calc.reset();
     }
-    for (auto const& detail : it->second) {
-        if (detail.iters >= iters) {
-            return detail;
+    auto is_connected = [](ClientDesc const& desc) { return !desc.reconnecting && desc.pclient; };
+    double best_score{0};
+    for (auto const& desc : m_timelords) {
+        if (is_connected(desc.second)) {
+            best_score = std::max(best_score, desc.second.pstats->GetHealthScore());
         }
     }
-    return {};
+    // The timelords which are much less healthy than the best connected one are asked later, they aren't asked at all
+    // when a proof is received before that. A timelord without any sample is never deferred.
+    std::vector<EndpointDesc> deferred;
+    for (auto const& desc : m_timelords) {
+        if (!is_connected(desc.second)) {
+            continue;
+        }
+        if (desc.second.pstats->HasSamples() &&
+            desc.second.pstats->GetHealthScore() < best_score * UNHEALTHY_SCORE_RATIO) {
+            deferred.push_back(desc.first);
+            continue;
+        }
+        desc.second.pclient->Calc(challenge, iters, group_hash, total_size, CHECKING_VDF_INTERVAL_SECS);
+    }
+    if (deferred.empty()) {
+        return;
+    }
+    PLOGD << tinyformat::format("%d unhealthy timelord(s) will be asked after %d seconds", deferred.size(),
+                                DEFERRED_CALC_SECS);
+    m_ptimer_deferred_calc = std::make_shared<asio::steady_timer>(m_ioc);
+    m_ptimer_deferred_calc->expires_after(std::chrono::seconds(DEFERRED_CALC_SECS));
+    m_ptimer_deferred_calc->async_wait(
+            [this, deferred, challenge, iters, group_hash, total_size](asio::error_code const& ec) {
+                if (ec || m_shutting_down || challenge != m_calc_challenge || iters != m_calc_iters) {
+                    return;
+                }
+                // the clients might be replaced by the reconnections
+                for (auto const& endpoint : deferred) {
+                    auto it = m_timelords.find(endpoint);
+                    if (it != std::end(m_timelords) && !it->second.reconnecting && it->second.pclient) {
+                        it->second.pclient->Calc(challenge, iters, group_hash, total_size,
+                                                 CHECKING_VDF_INTERVAL_SECS);
+                    }
+                }
+            });
 }
 
-void Miner::SaveProof(uint256 const& challenge, ProofDetail const& detail) {
-    std::lock_guard<std::mutex> lg(m_mtx_proofs);
-    auto it = m_proofs.find(challenge);
-    if (it == std::end(m_proofs)) {
-        m_proofs.insert(std::make_pair(challenge, std::vector<ProofDetail>{detail}));
-    } else {
-        // exit if the proof does already exist
-        it->second.push_back(detail);
+void Miner::SaveProof(EndpointDesc const& endpoint, uint256 const& challenge, ProofDetail const& detail) {
+    // The first proof which satisfies the request wins, the other timelords don't need to be asked again. It doesn't
+    // depend on the store, a later proof can't win because the request is cleared here
+    bool first = challenge == m_calc_challenge && detail.iters >= m_calc_iters;
+    if (first) {
+        m_calc_challenge.SetNull();
+        for (auto const& desc : m_timelords) {
+            if (desc.second.pclient) {
+                desc.second.pclient->CancelCalc(challenge);
+            }
+        }
+    }
+    // The miner queries the store as soon as it is woken up, so the proof is saved before the notification
+    if (!m_proof_store.Save(challenge, detail)) {
+        // the same proof is received from another timelord
+        PLOGD << "proof does already exist, iters: " << detail.iters << ", from " << endpoint.ToString();
+        return;
+    }
+    m_challenge_monitor.Notify();
+    auto it = m_timelords.find(endpoint);
+    assert(it != std::end(m_timelords));
+    if (!first) {
+        PLOGI << "proof is saved, from " << endpoint.ToString();
+        return;
     }
-    PLOGI << "proof is saved.";
+    it->second.pstats->AddWin();
+    PLOGI << tinyformat::format("proof is saved, the first one from %s, %s", endpoint.ToString(),
+                                it->second.pstats->ToString());
 }
 
 }  // namespace miner
\ No newline at end of file
@@ -13,14 +13,21 @@
 
 #include <tinyformat.h>
 
+#include "challenge_monitor.h"
+#include "cpu_layout.h"
+#include "proof_store.h"
+#include "proof_submitter.h"
 #include "prover.h"
+#include "reconnect_backoff.h"
 #include "rpc_client.h"
 
 namespace miner {
 namespace pos {
 chiapos::optional<RPCClient::PosProof> QueryBestPosProof(Prover& prover, uint256 const& challenge, uint64_t difficulty,
                                                          int difficulty_constant_factor_bits, int filter_bits,
-                                                         int base_iters, chiapos::PubKey& out_farmer_pk,
+                                                         int base_iters, int num_candidates,
+                                                         chiapos::ProvingTicket const& ticket,
+                                                         chiapos::PubKey& out_farmer_pk,
                                                          std::string* out_plot_path = nullptr);
 }
 
@@ -36,13 +43,24 @@ struct EndpointDesc {
 struct ClientDesc {
     bool reconnecting;
     TimelordClientPtr pclient;
+    std::shared_ptr<TimelordStats> pstats;
+    ReconnectBackoff backoff;
+    std::shared_ptr<asio::steady_timer> ptimer_reconnect;
+    bool connected{false};
+    std::chrono::steady_clock::time_point connected_at;
 };
 
-/// Miner is a state machine
+/**
+ * @brief Miner is a state machine
+ *
+ * The stages overlap with each other: the challenge is watched by the monitor while the PoS is searched and the VDF
+ * is waited, the proofs are submitted on the submitter thread while the next challenge is processed.
+ */
 class Miner {
 public:
     Miner(RPCClient& client, Prover& prover, std::map<chiapos::PubKey, chiapos::SecreKey> secre_keys,
-          std::string reward_dest, int difficulty_constant_factor_bits, bool no_cuda, int max_compression_level, int timeout_seconds);
+          std::string reward_dest, int difficulty_constant_factor_bits, bool no_cuda, int max_compression_level, int timeout_seconds,
+          CpuLayout cpu_layout, int num_proof_candidates);
 
     ~Miner();
 
@@ -57,7 +75,7 @@ private:
 
     TimelordClientPtr PrepareTimelordClient(std::string const& hostname, unsigned short port);
 
-    /// A thread proc to check the challenge or the VDF from P2P network
+    /// Wait for the challenge to change or the VDF from P2P network and timelord
     BreakReason CheckAndBreak(std::atomic_bool& running, int timeout_seconds, uint256 const& initial_challenge,
                               uint256 const& current_challenge, uint64_t iters_limits, uint256 const& group_hash,
                               uint64_t total_size, chiapos::optional<RPCClient::VdfProof>& out_vdf);
@@ -68,7 +86,11 @@ private:
 
     chiapos::optional<ProofDetail> QueryProofFromTimelord(uint256 const& challenge, uint64_t iters) const;
 
-    void SaveProof(uint256 const& challenge, ProofDetail const& detail);
+    /// Send the CALC to the timelords, it runs on the timelord thread
+    void SendCalc(uint256 const& challenge, uint64_t iters, uint256 const& group_hash, uint64_t total_size);
+
+    /// Save the proof from the timelord, the first proof which satisfies the request stops the other timelords
+    void SaveProof(EndpointDesc const& endpoint, uint256 const& challenge, ProofDetail const& detail);
 
 private:
     // utilities
@@ -77,15 +99,21 @@ private:
     std::map<chiapos::PubKey, chiapos::SecreKey> m_secre_keys;
     std::string m_reward_dest;
     int m_difficulty_constant_factor_bits;
+    int m_num_proof_candidates;
+    CpuLayout m_cpu_layout;
+    ChallengeMonitor m_challenge_monitor;
+    ProofSubmitter m_proof_submitter;
     // State
     std::atomic<State> m_state{State::RequireChallenge};
     // thread and timelord
     asio::io_context m_ioc;
     std::unique_ptr<std::thread> m_pthread_timelord;
     std::map<EndpointDesc, ClientDesc> m_timelords;
-    mutable std::mutex m_mtx_proofs;
-    std::map<uint256, std::vector<ProofDetail>> m_proofs;
-    std::set<uint256> m_submit_history;
+    // the request sent to the timelords, only accessed from the timelord thread
+    uint256 m_calc_challenge;
+    uint64_t m_calc_iters{0};
+    std::shared_ptr<asio::steady_timer> m_ptimer_deferred_calc;
+    ProofStore m_proof_store;
     std::atomic_bool m_shutting_down{false};
     // temporary save the current challenge/iters
     uint256 m_current_challenge;
@@ -49,6 +49,13 @@ std::string Config::ToJsonString() const {
     }
     root.pushKV("allowedPlotK", allowed_ks);
 
+    UniValue decompressor(UniValue::VOBJ);
+    decompressor.pushKV("contexts", m_decompressor.contexts);
+    decompressor.pushKV("threadsPerContext", m_decompressor.threads_per_context);
+    decompressor.pushKV("reservedCores", m_decompressor.reserved_cores);
+    decompressor.pushKV("cpuAffinity", m_decompressor.cpu_affinity);
+    root.pushKV("decompressor", decompressor);
+
     return root.write(4);
 }
 
@@ -137,6 +144,22 @@ void Config::ParseFromJsonString(std::string const& json_str) {
             m_allowed_k_vec.push_back(k_val.get_int());
         }
     }
+
+    if (root.exists("decompressor") && root["decompressor"].isObject()) {
+        UniValue decompressor = root["decompressor"].get_obj();
+        if (decompressor.exists("contexts") && decompressor["contexts"].isNum()) {
+            m_decompressor.contexts = decompressor["contexts"].get_int();
+        }
+        if (decompressor.exists("threadsPerContext") && decompressor["threadsPerContext"].isNum()) {
+            m_decompressor.threads_per_context = decompressor["threadsPerContext"].get_int();
+        }
+        if (decompressor.exists("reservedCores") && decompressor["reservedCores"].isNum()) {
+            m_decompressor.reserved_cores = decompressor["reservedCores"].get_int();
+        }
+        if (decompressor.exists("cpuAffinity") && decompressor["cpuAffinity"].isBool()) {
+            m_decompressor.cpu_affinity = decompressor["cpuAffinity"].get_bool();
+        }
+    }
 }
 
 Config::RPC Config::GetRPC() const { return m_rpc; }
@@ -155,4 +178,6 @@ std::vector<std::string> Config::GetTimelordEndpoints() const { return m_timelor
 
 std::vector<uint8_t> Config::GetAllowedKs() const { return m_allowed_k_vec; }
 
+Config::Decompressor const& Config::GetDecompressor() const { return m_decompressor; }
+
 }  // namespace miner
@@ -20,6 +20,14 @@ public:
         std::string wallet;
     };
 
+    /// The layout of the decompressor threads for the compressed plots, see `MakeCpuLayout`
+    struct Decompressor {
+        int contexts{0};             // 0 to make one context for each NUMA node
+        int threads_per_context{0};  // 0 to share the unreserved cores evenly
+        int reserved_cores{1};       // the cores are left to the miner state machine and the network
+        bool cpu_affinity{true};
+    };
+
     std::string ToJsonString() const;
 
     void ParseFromJsonString(std::string const& json_str);
@@ -40,6 +48,8 @@ public:
 
     std::vector<uint8_t> GetAllowedKs() const;
 
+    Decompressor const& GetDecompressor() const;
+
 private:
     RPC m_rpc;
     std::string m_reward_dest;
@@ -49,6 +59,7 @@ private:
     bool m_no_proxy{true};
     std::vector<std::string> m_timelord_endpoints;
     std::vector<uint8_t> m_allowed_k_vec;
+    Decompressor m_decompressor;
 };
 
 }  // namespace miner
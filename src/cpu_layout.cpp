@@ -0,0 +1,214 @@
+#include "cpu_layout.h"
+
+#include <plog/Log.h>
+#include <tinyformat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include <bhd_types.h>
+
+#ifdef __linux__
+
+#include <pthread.h>
+#include <sched.h>
+
+#endif
+
+namespace miner {
+
+namespace {
+
+/// The node aligned ranges are too small to make the contexts from when the nodes are interleaved more than this
+int const MAX_ALIGNED_CONTEXTS_PER_NODE = 2;
+
+int GetNumOfCpus() { return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1); }
+
+}  // namespace
+
+std::vector<int> ParseCpuList(std::string const& str) {
+    std::vector<int> res;
+    std::stringstream ss(str);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (!range.empty() && range.back() == '\n') {
+            range.pop_back();
+        }
+        if (range.empty()) {
+            continue;
+        }
+        auto p = range.find('-');
+        try {
+            if (p == std::string::npos) {
+                res.push_back(std::stoi(range));
+            } else {
+                int first = std::stoi(range.substr(0, p));
+                int last = std::stoi(range.substr(p + 1));
+                if (first < 0 || first > last) {
+                    return {};
+                }
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    res.push_back(cpu);
+                }
+            }
+        } catch (std::exception const&) {
+            return {};
+        }
+    }
+    return res;
+}
+
+std::string CpuLayout::ToString() const {
+    std::stringstream ss;
+    for (int cpu : reserved_cpus) {
+        if (ss.tellp() > 0) {
+            ss << ",";
+        }
+        ss << cpu;
+    }
+    return tinyformat::format("contexts=%d, threads_per_context=%d, cpu_affinity=%s, reserved_cpus=[%s]",
+                              num_contexts, threads_per_context, (cpu_affinity ? "on" : "off"), ss.str());
+}
+
+std::vector<std::vector<int>> DetectNumaNodes() {
+    std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+    Path const NODE_ROOT("/sys/devices/system/node");
+    for (int node = 0;; ++node) {
+        std::ifstream in(NODE_ROOT / tinyformat::format("node%d", node) / "cpulist");
+        if (!in.is_open()) {
+            break;
+        }
+        std::string cpu_list;
+        std::getline(in, cpu_list);
+        auto cpus = ParseCpuList(cpu_list);
+        if (!cpus.empty()) {
+            nodes.push_back(std::move(cpus));
+        }
+    }
+#endif
+    if (nodes.empty()) {
+        std::vector<int> cpus(GetNumOfCpus());
+        for (int cpu = 0; cpu < static_cast<int>(cpus.size()); ++cpu) {
+            cpus[cpu] = cpu;
+        }
+        nodes.push_back(std::move(cpus));
+    }
+    return nodes;
+}
+
+int GetNodeAlignedRangeSize(std::vector<std::vector<int>> const& nodes) {
+    std::vector<int> owners;
+    for (std::size_t node = 0; node < nodes.size(); ++node) {
+        for (int cpu : nodes[node]) {
+            if (cpu < 0) {
+                return 0;
+            }
+            if (cpu >= static_cast<int>(owners.size())) {
+                owners.resize(cpu + 1, -1);
+            }
+            owners[cpu] = static_cast<int>(node);
+        }
+    }
+    if (owners.empty() || std::find(std::begin(owners), std::end(owners), -1) != std::end(owners)) {
+        return 0;
+    }
+    int size = static_cast<int>(owners.size());
+    for (int cpu = 1; cpu < static_cast<int>(owners.size()); ++cpu) {
+        if (owners[cpu] != owners[cpu - 1]) {
+            size = std::gcd(size, cpu);
+        }
+    }
+    return size;
+}
+
+CpuLayout MakeCpuLayout(std::vector<std::vector<int>> const& nodes, int num_contexts, int threads_per_context,
+                        int reserved_cores, bool cpu_affinity) {
+    int num_cpus{0};
+    for (auto const& cpus : nodes) {
+        num_cpus += static_cast<int>(cpus.size());
+    }
+    num_cpus = std::max(num_cpus, 1);
+    // At least one CPU is left to the decompressors
+    reserved_cores = std::min(std::max(reserved_cores, 0), num_cpus - 1);
+    int num_usable_cpus = num_cpus - reserved_cores;
+
+    CpuLayout layout;
+    layout.cpu_affinity = cpu_affinity;
+    if (!nodes.empty()) {
+        std::vector<int> last_node = nodes.back();
+        std::sort(std::begin(last_node), std::end(last_node));
+        int num_reserved = std::min(reserved_cores, static_cast<int>(last_node.size()));
+        layout.reserved_cpus.assign(std::end(last_node) - num_reserved, std::end(last_node));
+    }
+    int aligned_size = GetNodeAlignedRangeSize(nodes);
+    int max_aligned_contexts = static_cast<int>(nodes.size()) * MAX_ALIGNED_CONTEXTS_PER_NODE;
+    if (num_contexts <= 0 && threads_per_context <= 0 && nodes.size() > 1 && aligned_size > 0 &&
+        num_cpus / aligned_size <= max_aligned_contexts) {
+        // Line the contexts up with the node boundaries
+        layout.num_contexts = num_cpus / aligned_size;
+        layout.threads_per_context = aligned_size;
+        return layout;
+    }
+    layout.num_contexts = num_contexts > 0 ? num_contexts : static_cast<int>(std::max<std::size_t>(nodes.size(), 1));
+    layout.threads_per_context =
+            threads_per_context > 0 ? threads_per_context : std::max(num_usable_cpus / layout.num_contexts, 1);
+
+    if (layout.cpu_affinity) {
+        // Each context must be pinned inside one node, otherwise its threads access the memory of the other node
+        std::vector<std::set<int>> node_sets;
+        for (auto const& cpus : nodes) {
+            node_sets.emplace_back(std::begin(cpus), std::end(cpus));
+        }
+        for (int i = 0; i < layout.num_contexts && layout.cpu_affinity; ++i) {
+            int first = i * layout.threads_per_context;
+            int last = first + layout.threads_per_context - 1;
+            auto contains_context = [first, last](std::set<int> const& node_cpus) {
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    if (node_cpus.find(cpu) == std::end(node_cpus)) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            bool inside = std::any_of(std::begin(node_sets), std::end(node_sets), contains_context);
+            if (!inside) {
+                PLOGW << tinyformat::format(
+                        "decompressor context %d (cpu %d-%d) crosses the NUMA nodes, the decompressor threads are not "
+                        "pinned",
+                        i, first, last);
+                layout.cpu_affinity = false;
+            }
+        }
+    }
+    return layout;
+}
+
+CpuLayout MakeCpuLayout(int num_contexts, int threads_per_context, int reserved_cores, bool cpu_affinity) {
+    return MakeCpuLayout(DetectNumaNodes(), num_contexts, threads_per_context, reserved_cores, cpu_affinity);
+}
+
+bool PinCurrentThread(std::vector<int> const& cpus) {
+    if (cpus.empty()) {
+        return false;
+    }
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            return false;
+        }
+        CPU_SET(cpu, &cpu_set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+    return false;
+#endif
+}
+
+}  // namespace miner
@@ -0,0 +1,64 @@
+#ifndef DEPINC_MINER_CPU_LAYOUT_H
+#define DEPINC_MINER_CPU_LAYOUT_H
+
+#include <string>
+#include <vector>
+
+namespace miner {
+
+/**
+ * @brief How the decompressor contexts are placed on the CPUs
+ *
+ * The decompressor context queue can only pin the threads of the context `i` to the contiguous CPUs
+ * [i * threads_per_context, (i + 1) * threads_per_context), so the contexts are only pinned when each of these ranges
+ * is inside one NUMA node. The reserved CPUs are the last ones of the last node, they are left to the miner state
+ * machine, the timelord client and curl.
+ */
+struct CpuLayout {
+    int num_contexts{1};
+    int threads_per_context{1};
+    bool cpu_affinity{true};
+    std::vector<int> reserved_cpus;
+
+    std::string ToString() const;
+};
+
+/// Parse the cpu list from sysfs, e.g. "0-15,32-47", returns empty when it is invalid
+std::vector<int> ParseCpuList(std::string const& str);
+
+/// The CPUs of each NUMA node, all CPUs are in one node when the topology cannot be read
+std::vector<std::vector<int>> DetectNumaNodes();
+
+/**
+ * @brief The size of the CPU ranges [i * size, (i + 1) * size) which never cross the NUMA nodes, it is the greatest
+ * common divisor of the boundaries of the nodes, e.g. 32 for the nodes 0-31/32-63 and 16 for the nodes
+ * 0-15,32-47/16-31,48-63. Returns 0 when the CPUs aren't numbered from 0 without gaps.
+ */
+int GetNodeAlignedRangeSize(std::vector<std::vector<int>> const& nodes);
+
+/**
+ * @brief Make the layout of the decompressor contexts
+ *
+ * With the default settings and more than one node, each context takes a node aligned range of CPUs (see
+ * `GetNodeAlignedRangeSize`), the reserved CPUs are shared with the last context then because the range of a
+ * context cannot be shortened alone. When the nodes are interleaved too finely for that, the layout is made as with
+ * the explicit settings and the threads aren't pinned. With one node the context takes the CPUs which aren't reserved.
+ *
+ * @param nodes The CPUs of each NUMA node
+ * @param num_contexts The number of the decompressor contexts, 0 to make them by the NUMA nodes
+ * @param threads_per_context The number of threads of each context, 0 to make them by the NUMA nodes
+ * @param reserved_cores How many CPUs are reserved for the miner
+ * @param cpu_affinity Pin the decompressor threads, it is turned off when a context would cross the NUMA nodes
+ */
+CpuLayout MakeCpuLayout(std::vector<std::vector<int>> const& nodes, int num_contexts, int threads_per_context,
+                        int reserved_cores, bool cpu_affinity);
+
+/// Make the layout with the NUMA nodes of this host
+CpuLayout MakeCpuLayout(int num_contexts, int threads_per_context, int reserved_cores, bool cpu_affinity);
+
+/// Run the current thread only on the CPUs, returns false when it isn't supported or the CPUs are invalid
+bool PinCurrentThread(std::vector<int> const& cpus);
+
+}  // namespace miner
+
+#endif
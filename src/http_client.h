@@ -9,31 +9,39 @@
 
 namespace miner {
 
+/**
+ * @brief A JSON-RPC connection to the node, the curl handle, the headers and the receiving buffer are kept between
+ * requests so the connection is reused (HTTP keep-alive) when the client is sending more than one request
+ */
 class HTTPClient {
 public:
     HTTPClient(std::string url, std::string user, std::string passwd, bool no_proxy);
 
     ~HTTPClient();
 
+    HTTPClient(HTTPClient const&) = delete;
+
+    HTTPClient& operator=(HTTPClient const&) = delete;
+
     std::tuple<bool, int, std::string> Send(std::string const& buff);
 
-    chiapos::Bytes GetReceivedData() const;
+    /// The data received from the last `Send()`
+    chiapos::Bytes const& GetReceivedData() const;
+
+    bool IsNoProxy() const { return m_no_proxy; }
 
 private:
     void AppendRecvData(char const* ptr, size_t total);
 
     static size_t RecvCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
 
-    static size_t SendCallback(char* buffer, size_t size, size_t nitems, void* userdata);
-
 private:
     CURL* m_curl;
+    curl_slist* m_header_list{nullptr};
     std::string m_url;
     std::string m_user;
     std::string m_passwd;
     bool m_no_proxy;
-    chiapos::Bytes m_send_data;
-    size_t m_send_data_offset{0};
     chiapos::Bytes m_recv_data;
 };
 
@@ -9,6 +9,7 @@
 
 #include <asio.hpp>
 
+#include <curl/curl.h>
 #include <cxxopts.hpp>
 #include <fstream>
 #include <functional>
@@ -31,7 +32,9 @@
 #include <rpc_client.h>
 #include <http_client.h>
 #include <config.h>
+#include <cpu_layout.h>
 #include <prover.h>
+#include <plot_watcher.h>
 #include <tools.h>
 #include <chiapos_miner.h>
 
@@ -117,11 +120,15 @@ struct Arguments {
     int difficulty_constant_factor_bits;  // dcf bits (chain parameter)
     std::string datadir;                  // The root path of the data directory
     std::string cookie_path;              // The file stores the connecting information of current depinc server
-    std::string posproofs_path;           // The pos proofs for testing timeing
     // args for compressed plots
     bool no_cuda;
     int max_compression_leve;
     int timeout_seconds;
+    int proof_candidates;  // how many best proofs are fetched at the same time
+    bool no_plot_watcher;  // do not watch the plot dirs for changes
+    std::string plot_cache_path;  // the plot headers are saved to this file
+    int max_opened_plots;         // 0 to keep all plots opened
+    Config::Decompressor decompressor;  // from the config, overridden by the arguments
 } g_args;
 
 miner::Config g_config;
@@ -135,7 +142,7 @@ std::map<chiapos::PubKey, chiapos::SecreKey> ConvertSecureKeys(std::vector<std::
     }
     for (auto const& sk_pair : res) {
         PLOGI << tinyformat::format("Read farmer public-key: %s",
-                                    chiapos::BytesToHex(chiapos::MakeBytes(sk_pair.first)));
+                                    chiapos::BytesToHex(sk_pair.first));
     }
     return res;
 }
@@ -169,12 +176,23 @@ int HandleCommand_GenConfig(std::string const& config_path) {
 }
 
 int HandleCommand_Mining() {
-    miner::Prover prover(miner::StrListToPathList(miner::g_config.GetPlotPath()), miner::g_config.GetAllowedKs());
+    chiapos::SetMaxOpenedPlots(miner::g_args.max_opened_plots);
+    auto plot_dirs = miner::StrListToPathList(miner::g_config.GetPlotPath());
+    miner::Prover prover(plot_dirs, miner::g_config.GetAllowedKs(), miner::g_args.plot_cache_path);
+    miner::PlotWatcher plot_watcher(prover, plot_dirs);
+    if (!miner::g_args.no_plot_watcher) {
+        plot_watcher.Start();
+    }
     std::unique_ptr<miner::RPCClient> pclient = tools::CreateRPCClient(miner::g_config, miner::g_args.cookie_path);
+    auto const& decompressor = miner::g_args.decompressor;
+    auto cpu_layout = miner::MakeCpuLayout(decompressor.contexts, decompressor.threads_per_context,
+                                           decompressor.reserved_cores, decompressor.cpu_affinity);
+    PLOGI << "decompressor layout: " << cpu_layout.ToString();
     // Start mining
     miner::Miner miner(*pclient, prover, miner::ConvertSecureKeys(miner::g_config.GetSeeds()),
                        miner::g_config.GetRewardDest(), miner::g_args.difficulty_constant_factor_bits, miner::g_args.no_cuda,
-                       miner::g_args.max_compression_leve, miner::g_args.timeout_seconds);
+                       miner::g_args.max_compression_leve, miner::g_args.timeout_seconds, cpu_layout,
+                       miner::g_args.proof_candidates);
     // do we have timelord service
     auto timelord_endpoints = miner::g_config.GetTimelordEndpoints();
     miner.StartTimelord(timelord_endpoints, 19191);
@@ -310,11 +328,18 @@ int main(int argc, char** argv) {
             ("d,datadir", "The root path of the data directory",
              cxxopts::value<std::string>())  // --datadir, -d
             ("cookie", "Full path to `.cookie` from depinc datadir",
-             cxxopts::value<std::string>())                                                       // --cookie
-            ("posproofs", "Path to the file contains PoS proofs", cxxopts::value<std::string>())  // --posproofs
+             cxxopts::value<std::string>())  // --cookie
             ("no-cuda", "Do not use GPU to do the farming", cxxopts::value<bool>()->default_value("0")) // --no-cuda
             ("max-compression-level", "The number of the level to support the max compression", cxxopts::value<int>()->default_value("9")) // --max-compression-level
             ("timeout-seconds", "How many seconds to wait for the answer?", cxxopts::value<int>()->default_value("30")) // --timeout-seconds
+            ("plot-cache", "The file to save the plot headers, the plots are loaded from it on the next start, turn it off with an empty string", cxxopts::value<std::string>()->default_value("plots.cache")) // --plot-cache
+            ("max-opened-plots", "Keep at most this number of plots opened, the others are opened when they pass the filter, 0 to keep all plots opened", cxxopts::value<int>()->default_value("0")) // --max-opened-plots
+            ("no-plot-watcher", "Do not watch the plot dirs, the plots are only loaded on start", cxxopts::value<bool>()->default_value("0")) // --no-plot-watcher
+            ("proof-candidates", "How many best proofs are fetched at the same time, the first valid one is submitted", cxxopts::value<int>()->default_value("1")) // --proof-candidates
+            ("decompressor-contexts", "The number of decompressor contexts, 0 to make one context for each NUMA node", cxxopts::value<int>()) // --decompressor-contexts
+            ("decompressor-threads", "The number of threads of each decompressor context, 0 to share the unreserved cores evenly", cxxopts::value<int>()) // --decompressor-threads
+            ("reserved-cores", "How many cores are left to the miner state machine and the network, the last cores are reserved", cxxopts::value<int>()) // --reserved-cores
+            ("no-cpu-affinity", "Do not pin the decompressor threads and the miner thread to the cores", cxxopts::value<bool>()->default_value("0")) // --no-cpu-affinity
             ("command", std::string("Command") + miner::GetCommandsList(),
              cxxopts::value<std::string>())  // --command
             ;
@@ -344,6 +369,15 @@ int main(int argc, char** argv) {
 
     PLOG_DEBUG << "Initialized log system";
 
+    // The http clients are created lazily from several threads, curl must be initialized before any of them starts
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+        PLOGE << "cannot initialize curl";
+        return 1;
+    }
+    struct CurlGlobalCleanup {
+        ~CurlGlobalCleanup() { curl_global_cleanup(); }
+    } curl_global_cleanup_guard;
+
     if (result.count("command")) {
         miner::g_args.command = result["command"].as<std::string>();
     } else {
@@ -409,15 +443,28 @@ int main(int argc, char** argv) {
         }
     }
 
-    if (result.count("posproofs")) {
-        miner::g_args.posproofs_path = result["posproofs"].as<std::string>();
-    }
-
     miner::g_args.difficulty_constant_factor_bits = result["dcf-bits"].as<int>();
 
     miner::g_args.no_cuda = result["no-cuda"].as<bool>();
     miner::g_args.max_compression_leve = result["max-compression-level"].as<int>();
     miner::g_args.timeout_seconds = result["timeout-seconds"].as<int>();
+    miner::g_args.proof_candidates = std::max(result["proof-candidates"].as<int>(), 1);
+    miner::g_args.no_plot_watcher = result["no-plot-watcher"].as<bool>();
+    miner::g_args.plot_cache_path = result["plot-cache"].as<std::string>();
+    miner::g_args.max_opened_plots = std::max(result["max-opened-plots"].as<int>(), 0);
+    miner::g_args.decompressor = miner::g_config.GetDecompressor();
+    if (result.count("decompressor-contexts")) {
+        miner::g_args.decompressor.contexts = std::max(result["decompressor-contexts"].as<int>(), 0);
+    }
+    if (result.count("decompressor-threads")) {
+        miner::g_args.decompressor.threads_per_context = std::max(result["decompressor-threads"].as<int>(), 0);
+    }
+    if (result.count("reserved-cores")) {
+        miner::g_args.decompressor.reserved_cores = std::max(result["reserved-cores"].as<int>(), 0);
+    }
+    if (result["no-cpu-affinity"].as<bool>()) {
+        miner::g_args.decompressor.cpu_affinity = false;
+    }
 
     PLOG_INFO << "network: " << (miner::g_config.Testnet() ? "testnet" : "main");
 
@@ -12,6 +12,7 @@ enum class TimelordMsgs : int {
     READY = 1020,
     SPEED = 1030,
     CALC_REPLY = 1040,
+    FRAMING_REPLY = 1050,
 };
 
 inline std::string TimelordMsgIdToString(TimelordMsgs msg_id) {
@@ -26,6 +27,8 @@ inline std::string TimelordMsgIdToString(TimelordMsgs msg_id) {
             return "SPEED";
         case TimelordMsgs::CALC_REPLY:
             return "CALC_REPLY";
+        case TimelordMsgs::FRAMING_REPLY:
+            return "FRAMING_REPLY";
     }
     throw std::runtime_error("wrong timelord message string");
 }
@@ -35,6 +38,7 @@ enum class TimelordClientMsgs : int {
     PING = 2000,
     CALC = 2010,
     QUERY_SPEED = 2020,
+    FRAMING = 2030,
 };
 
 #endif
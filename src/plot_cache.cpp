@@ -0,0 +1,111 @@
+#include "plot_cache.h"
+
+#include <plog/Log.h>
+#include <tinyformat.h>
+#include <univalue.h>
+
+#include <bhd_types.h>
+#include <utils.h>
+
+#include <fstream>
+#include <sstream>
+
+namespace miner {
+
+namespace {
+
+int const CACHE_VERSION = 1;
+
+}  // namespace
+
+PlotHeaderCache::PlotHeaderCache(std::string file_path) : m_file_path(std::move(file_path)) {}
+
+bool PlotHeaderCache::Load() {
+    std::ifstream in(m_file_path);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    UniValue root;
+    if (!root.read(ss.str()) || !root.isObject()) {
+        PLOGE << tinyformat::format("cannot parse plot cache: %s", m_file_path);
+        return false;
+    }
+    m_entries.clear();
+    try {
+        // `get_int` throws when the version isn't an integer, the cache is treated as broken then
+        if (!root.exists("version") || root["version"].get_int() != CACHE_VERSION || !root["plots"].isArray()) {
+            PLOGI << tinyformat::format("the version of plot cache is mismatched, ignore it: %s", m_file_path);
+            return false;
+        }
+        for (auto const& plot : root["plots"].getValues()) {
+            Entry entry;
+            entry.size = plot["size"].get_int64();
+            entry.mtime = plot["mtime"].get_int64();
+            entry.header.plot_id = uint256S(plot["id"].get_str());
+            entry.header.k = plot["k"].get_int();
+            entry.header.compression_level = plot["compression_level"].get_int();
+            entry.header.memo = chiapos::BytesFromHex(plot["memo"].get_str());
+            m_entries[plot["path"].get_str()] = std::move(entry);
+        }
+    } catch (std::exception const& e) {
+        PLOGE << tinyformat::format("plot cache is broken: %s, %s", m_file_path, e.what());
+        m_entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool PlotHeaderCache::Save() const {
+    UniValue plots(UniValue::VARR);
+    for (auto const& entry : m_entries) {
+        UniValue plot(UniValue::VOBJ);
+        plot.pushKV("path", entry.first);
+        plot.pushKV("size", entry.second.size);
+        plot.pushKV("mtime", entry.second.mtime);
+        plot.pushKV("id", entry.second.header.plot_id.GetHex());
+        plot.pushKV("k", (int)entry.second.header.k);
+        plot.pushKV("compression_level", (int)entry.second.header.compression_level);
+        plot.pushKV("memo", chiapos::BytesToHex(entry.second.header.memo));
+        plots.push_back(plot);
+    }
+    UniValue root(UniValue::VOBJ);
+    root.pushKV("version", CACHE_VERSION);
+    root.pushKV("plots", plots);
+
+    std::string tmp_path = m_file_path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        if (!out.is_open()) {
+            PLOGE << tinyformat::format("cannot write plot cache: %s", tmp_path);
+            return false;
+        }
+        out << root.write();
+        if (!out.good()) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp_path, m_file_path, ec);
+    if (ec) {
+        PLOGE << tinyformat::format("cannot save plot cache: %s, %s", m_file_path, ec.message());
+        return false;
+    }
+    return true;
+}
+
+chiapos::optional<chiapos::PlotHeader> PlotHeaderCache::Find(std::string const& plot_path, uint64_t size,
+                                                             int64_t mtime) const {
+    auto it = m_entries.find(plot_path);
+    if (it == std::end(m_entries) || it->second.size != size || it->second.mtime != mtime) {
+        return {};
+    }
+    return it->second.header;
+}
+
+void PlotHeaderCache::Put(std::string const& plot_path, uint64_t size, int64_t mtime, chiapos::PlotHeader header) {
+    m_entries[plot_path] = Entry{size, mtime, std::move(header)};
+}
+
+}  // namespace miner
@@ -0,0 +1,46 @@
+#ifndef DEPINC_MINER_PLOT_CACHE_H
+#define DEPINC_MINER_PLOT_CACHE_H
+
+#include <chiapos_types.h>
+#include <pos.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace miner {
+
+/**
+ * @brief The headers of plots saved on disk, a plot is found by its path and it is only valid when the file size and
+ * the modified time are not changed
+ */
+class PlotHeaderCache {
+public:
+    explicit PlotHeaderCache(std::string file_path);
+
+    /// Load the cache from file, returns false when the file doesn't exist or it cannot be parsed
+    bool Load();
+
+    /// Write the cache to a temporary file and rename it to the cache file
+    bool Save() const;
+
+    chiapos::optional<chiapos::PlotHeader> Find(std::string const& plot_path, uint64_t size, int64_t mtime) const;
+
+    void Put(std::string const& plot_path, uint64_t size, int64_t mtime, chiapos::PlotHeader header);
+
+    std::size_t Size() const { return m_entries.size(); }
+
+private:
+    struct Entry {
+        uint64_t size;
+        int64_t mtime;
+        chiapos::PlotHeader header;
+    };
+
+    std::string m_file_path;
+    std::unordered_map<std::string, Entry> m_entries;
+};
+
+}  // namespace miner
+
+#endif
@@ -0,0 +1,67 @@
+#include "plot_filter.h"
+
+#include <pos.h>
+#include <sha256.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace miner {
+
+void PlotFilterIndex::Add(uint256 const& plot_id) {
+    PlotIdEntry entry;
+    memcpy(entry.data, plot_id.begin(), sizeof(entry.data));
+    m_plot_ids.push_back(entry);
+}
+
+void PlotFilterIndex::Remove(std::size_t index) {
+    m_plot_ids[index] = m_plot_ids.back();
+    m_plot_ids.pop_back();
+}
+
+void PlotFilterIndex::Clear() { m_plot_ids.clear(); }
+
+uint256 PlotFilterIndex::Get(std::size_t index) const {
+    uint256 plot_id;
+    memcpy(plot_id.begin(), m_plot_ids[index].data, plot_id.size());
+    return plot_id;
+}
+
+std::vector<std::size_t> PlotFilterIndex::Filter(uint256 const& challenge, int bits) const {
+    std::vector<std::size_t> res;
+    if (bits <= 0) {
+        res.resize(m_plot_ids.size());
+        for (std::size_t i = 0; i < res.size(); ++i) {
+            res[i] = i;
+        }
+        return res;
+    }
+    // Only the first word of the digest is compared, the rest of the bits are checked by the original filter
+    uint32_t mask = bits >= 32 ? 0xffffffff : ~(0xffffffff >> bits);
+    for (std::size_t i = 0; i < m_plot_ids.size(); i += sha256::MULTI_WAYS) {
+        std::size_t n = std::min<std::size_t>(sha256::MULTI_WAYS, m_plot_ids.size() - i);
+        uint8_t const* prefixes[sha256::MULTI_WAYS];
+        for (int l = 0; l < sha256::MULTI_WAYS; ++l) {
+            // The lanes over the end are filled with the last plot, their results are ignored
+            prefixes[l] = m_plot_ids[i + std::min<std::size_t>(l, n - 1)].data;
+        }
+        uint32_t first_words[sha256::MULTI_WAYS];
+        sha256::HashPairsFirstWord(first_words, prefixes, challenge.begin());
+        for (std::size_t l = 0; l < n; ++l) {
+            if ((first_words[l] & mask) != 0) {
+                continue;
+            }
+            if (bits > 32) {
+                uint256 plot_id;
+                memcpy(plot_id.begin(), prefixes[l], plot_id.size());
+                if (!chiapos::PassesFilter(plot_id, challenge, bits)) {
+                    continue;
+                }
+            }
+            res.push_back(i + l);
+        }
+    }
+    return res;
+}
+
+}  // namespace miner
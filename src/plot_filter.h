@@ -0,0 +1,49 @@
+#ifndef DEPINC_MINER_PLOT_FILTER_H
+#define DEPINC_MINER_PLOT_FILTER_H
+
+#include <uint256.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace miner {
+
+/**
+ * @brief The plot-ids of all plots stored in a contiguous array, the filter of a challenge is evaluated for all plots
+ * in one pass with the multi-buffer SHA-256 kernel
+ */
+class PlotFilterIndex {
+public:
+    void Add(uint256 const& plot_id);
+
+    /// Remove the plot-id by its index, the last plot-id is moved to its place
+    void Remove(std::size_t index);
+
+    void Clear();
+
+    std::size_t Size() const { return m_plot_ids.size(); }
+
+    uint256 Get(std::size_t index) const;
+
+    /**
+     * @brief Find the plots which pass the filter of the challenge
+     *
+     * @param challenge The challenge
+     * @param bits The number of leading zero bits required, all plots pass the filter when it is zero
+     *
+     * @return The indexes of the passed plots, in the order of their indexes
+     */
+    std::vector<std::size_t> Filter(uint256 const& challenge, int bits) const;
+
+private:
+    struct alignas(32) PlotIdEntry {
+        uint8_t data[32];
+    };
+
+    std::vector<PlotIdEntry> m_plot_ids;
+};
+
+}  // namespace miner
+
+#endif
@@ -0,0 +1,157 @@
+#include "plot_registry.h"
+
+#include <sha256.h>
+#include <utils.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace miner {
+
+void PlotRegistry::Add(chiapos::CPlotFile plot_file, uint64_t file_size, DiskId disk_id) {
+    chiapos::PlotMemo memo;
+    chiapos::PubKey farmer_pk{};
+    if (plot_file.ReadMemo(memo) && memo.farmer_pk.size() == farmer_pk.size()) {
+        farmer_pk = chiapos::MakeArray<chiapos::PK_LEN>(memo.farmer_pk);
+    }
+    uint32_t farmer_index = InternFarmerPk(farmer_pk);
+    FarmerGroup& group = m_farmers[farmer_index];
+    ++group.num_plots;
+    group.total_size += file_size;
+    // the key might be revoked before any plot of it is added
+    if (group.revoked) {
+        ++m_num_revoked_plots;
+    }
+    m_ids.Add(plot_file.GetPlotId());
+    m_ks.push_back(plot_file.GetK());
+    m_farmer_indexes.push_back(farmer_index);
+    m_disk_ids.push_back(disk_id);
+    m_file_sizes.push_back(file_size);
+    m_plot_files.push_back(std::move(plot_file));
+    m_path_index[m_plot_files.back().GetPath()] = m_plot_files.size() - 1;
+}
+
+void PlotRegistry::Erase(std::size_t index) {
+    assert(index < m_plot_files.size());
+    RemoveFromGroup(index);
+    m_path_index.erase(m_plot_files[index].GetPath());
+    std::size_t last = m_plot_files.size() - 1;
+    if (index != last) {
+        // The key refers the path of the moved plot, it is added again after the plot is moved
+        m_path_index.erase(m_plot_files[last].GetPath());
+        m_ks[index] = m_ks[last];
+        m_farmer_indexes[index] = m_farmer_indexes[last];
+        m_disk_ids[index] = m_disk_ids[last];
+        m_file_sizes[index] = m_file_sizes[last];
+        m_plot_files[index] = std::move(m_plot_files[last]);
+        m_path_index[m_plot_files[index].GetPath()] = index;
+    }
+    m_ids.Remove(index);
+    m_ks.pop_back();
+    m_farmer_indexes.pop_back();
+    m_disk_ids.pop_back();
+    m_file_sizes.pop_back();
+    m_plot_files.pop_back();
+}
+
+std::size_t PlotRegistry::EraseIf(std::function<bool(std::size_t index)> const& pred) {
+    std::size_t num_removed{0};
+    // Go backward, the plot moved to a removed index is already checked
+    for (std::size_t i = m_plot_files.size(); i > 0; --i) {
+        if (pred(i - 1)) {
+            Erase(i - 1);
+            ++num_removed;
+        }
+    }
+    return num_removed;
+}
+
+void PlotRegistry::Clear() {
+    m_ids.Clear();
+    m_ks.clear();
+    m_farmer_indexes.clear();
+    m_disk_ids.clear();
+    m_file_sizes.clear();
+    m_plot_files.clear();
+    m_path_index.clear();
+    for (auto& group : m_farmers) {
+        group.num_plots = 0;
+        group.total_size = 0;
+    }
+    m_num_revoked_plots = 0;
+}
+
+std::vector<std::size_t> PlotRegistry::Filter(uint256 const& challenge, int bits) const {
+    auto passed = m_ids.Filter(challenge, bits);
+    if (m_num_revoked_plots > 0) {
+        passed.erase(std::remove_if(std::begin(passed), std::end(passed),
+                                    [this](std::size_t i) { return IsRevoked(i); }),
+                     std::end(passed));
+    }
+    return passed;
+}
+
+std::size_t PlotRegistry::FindFarmer(chiapos::PubKey const& farmer_pk) const {
+    auto it = m_farmer_lookup.find(farmer_pk);
+    if (it == std::end(m_farmer_lookup) || m_farmers[it->second].num_plots == 0) {
+        return npos;
+    }
+    return it->second;
+}
+
+std::size_t PlotRegistry::RevokeFarmer(chiapos::PubKey const& farmer_pk) {
+    FarmerGroup& group = m_farmers[InternFarmerPk(farmer_pk)];
+    if (group.revoked) {
+        return 0;
+    }
+    group.revoked = true;
+    m_num_revoked_plots += group.num_plots;
+    return group.num_plots;
+}
+
+std::size_t PlotRegistry::Find(std::string const& path) const {
+    auto it = m_path_index.find(path);
+    if (it == std::end(m_path_index)) {
+        return npos;
+    }
+    return it->second;
+}
+
+uint256 PlotRegistry::CalculateGroupHash() const {
+    sha256::Hasher generator;
+    for (std::size_t i = 0; i < m_ids.Size(); ++i) {
+        if (IsRevoked(i)) {
+            continue;
+        }
+        uint256 plot_id = m_ids.Get(i);
+        generator.Write(plot_id.begin(), plot_id.size());
+    }
+    uint256 group_hash;
+    generator.Finalize(group_hash.begin());
+    return group_hash;
+}
+
+uint32_t PlotRegistry::InternFarmerPk(chiapos::PubKey const& farmer_pk) {
+    auto it = m_farmer_lookup.find(farmer_pk);
+    if (it != std::end(m_farmer_lookup)) {
+        return it->second;
+    }
+    uint32_t farmer_index = m_farmers.size();
+    FarmerGroup group;
+    group.farmer_pk = farmer_pk;
+    m_farmers.push_back(std::move(group));
+    m_farmer_lookup.insert(std::make_pair(farmer_pk, farmer_index));
+    return farmer_index;
+}
+
+void PlotRegistry::RemoveFromGroup(std::size_t index) {
+    FarmerGroup& group = m_farmers[m_farmer_indexes[index]];
+    assert(group.num_plots > 0);
+    --group.num_plots;
+    group.total_size -= m_file_sizes[index];
+    if (group.revoked) {
+        --m_num_revoked_plots;
+    }
+}
+
+}  // namespace miner
@@ -0,0 +1,123 @@
+#ifndef DEPINC_MINER_PLOT_REGISTRY_H
+#define DEPINC_MINER_PLOT_REGISTRY_H
+
+#include <bls_key.h>
+#include <plot_filter.h>
+#include <pos.h>
+#include <uint256.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace miner {
+
+/// Identifies the physical device a plot file is stored on, plots on the same device share the same id
+using DiskId = uint64_t;
+
+/// The plots signed by the same farmer public-key
+struct FarmerGroup {
+    chiapos::PubKey farmer_pk;
+    uint32_t num_plots{0};
+    uint64_t total_size{0};
+    bool revoked{false};  // the plots are kept but they are skipped by the filter and the summary
+};
+
+/**
+ * @brief All plots of the prover, each field of the plots is stored in its own contiguous array so a pass over one
+ * field (e.g. the plot-ids for the filter) doesn't touch the others
+ *
+ * A plot is referred by its index, the last plot takes the index of a removed plot so a removal doesn't move the
+ * other plots and the indexes are only valid until the registry is changed. The plots are also grouped by
+ * their farmer public-keys when they are added, the memo isn't read again to find the plots of a farmer.
+ */
+class PlotRegistry {
+public:
+    static std::size_t const npos = static_cast<std::size_t>(-1);
+
+    std::size_t Size() const { return m_plot_files.size(); }
+
+    bool Empty() const { return m_plot_files.empty(); }
+
+    /// The number of plots which aren't revoked
+    std::size_t GetNumOfActivePlots() const { return m_plot_files.size() - m_num_revoked_plots; }
+
+    /// Add an opened plot to the end
+    void Add(chiapos::CPlotFile plot_file, uint64_t file_size, DiskId disk_id);
+
+    /// Remove the plot, the last plot is moved to the index
+    void Erase(std::size_t index);
+
+    /// Remove the plots which match the predicate, the predicate is called on each plot once, returns the number of
+    /// removed plots
+    std::size_t EraseIf(std::function<bool(std::size_t index)> const& pred);
+
+    void Clear();
+
+    /// Find the plot by its path, returns `npos` when it isn't found
+    std::size_t Find(std::string const& path) const;
+
+    /// Find the plots pass the filter, the plots of the revoked farmers are skipped
+    std::vector<std::size_t> Filter(uint256 const& challenge, int bits) const;
+
+    /// Find the farmer group by the public-key, returns `npos` when no plot is signed by the key
+    std::size_t FindFarmer(chiapos::PubKey const& farmer_pk) const;
+
+    /**
+     * @brief Revoke the plots of the farmer, returns the number of the plots newly revoked
+     *
+     * The key is kept revoked even when no plot is signed by it yet, the plots added later are revoked when they are
+     * added.
+     */
+    std::size_t RevokeFarmer(chiapos::PubKey const& farmer_pk);
+
+    std::vector<FarmerGroup> const& GetFarmerGroups() const { return m_farmers; }
+
+    bool IsRevoked(std::size_t index) const { return m_farmers[m_farmer_indexes[index]].revoked; }
+
+    chiapos::CPlotFile const& GetPlotFile(std::size_t index) const { return m_plot_files[index]; }
+
+    uint8_t GetK(std::size_t index) const { return m_ks[index]; }
+
+    DiskId GetDiskId(std::size_t index) const { return m_disk_ids[index]; }
+
+    uint64_t GetFileSize(std::size_t index) const { return m_file_sizes[index]; }
+
+    /// The index of the farmer public-key in the farmer table
+    uint32_t GetFarmerIndex(std::size_t index) const { return m_farmer_indexes[index]; }
+
+    chiapos::PubKey const& GetFarmerPk(uint32_t farmer_index) const { return m_farmers[farmer_index].farmer_pk; }
+
+    std::vector<DiskId> const& GetDiskIds() const { return m_disk_ids; }
+
+    /// The hash of all plot-ids in the order of their indexes, the revoked plots are excluded
+    uint256 CalculateGroupHash() const;
+
+private:
+    uint32_t InternFarmerPk(chiapos::PubKey const& farmer_pk);
+
+    void RemoveFromGroup(std::size_t index);
+
+    PlotFilterIndex m_ids;
+    std::vector<uint8_t> m_ks;
+    std::vector<uint32_t> m_farmer_indexes;
+    std::vector<DiskId> m_disk_ids;
+    std::vector<uint64_t> m_file_sizes;
+    std::vector<chiapos::CPlotFile> m_plot_files;  // the handles to read the plots, only touched by the passed plots
+    // The farmer table, the public-keys are stored only once for all plots, the groups are never removed so the
+    // farmer indexes of the plots are stable
+    std::vector<FarmerGroup> m_farmers;
+    std::map<chiapos::PubKey, uint32_t> m_farmer_lookup;
+    std::size_t m_num_revoked_plots{0};
+    // The keys refer the paths which are owned by the plot files
+    std::unordered_map<std::string_view, std::size_t> m_path_index;
+};
+
+}  // namespace miner
+
+#endif
@@ -0,0 +1,265 @@
+#include "plot_watcher.h"
+
+#include <plog/Log.h>
+#include <tinyformat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+#ifdef __linux__
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#endif
+
+namespace miner {
+
+namespace {
+
+#ifdef __linux__
+int const POLL_TIMEOUT_MILLIS = 1000;
+#endif
+
+/// How often the dirs are checked again when they cannot be watched
+int const RESCAN_INTERVAL_SECS = 60;
+
+bool IsInDir(std::string const& file_path, std::string const& dir) {
+    fs::path dir_path = fs::path(dir).lexically_normal();
+    if (!dir_path.has_filename()) {
+        // ends with a separator
+        dir_path = dir_path.parent_path();
+    }
+    return fs::path(file_path).parent_path().lexically_normal() == dir_path;
+}
+
+}  // namespace
+
+PlotWatcher::PlotWatcher(Prover& prover, std::vector<Path> dirs) : m_prover(prover) {
+    for (auto const& dir : dirs) {
+        m_dirs.push_back(dir.string());
+    }
+}
+
+PlotWatcher::~PlotWatcher() { Stop(); }
+
+void PlotWatcher::Start() {
+    if (m_running.exchange(true)) {
+        return;
+    }
+#ifdef __linux__
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        PLOGE << "cannot initialize inotify, the plot dirs are rescanned periodically";
+    } else {
+        for (auto const& dir : m_dirs) {
+            AddWatch(dir);
+        }
+    }
+#endif
+    m_thread = std::thread(&PlotWatcher::WatchProc, this);
+}
+
+void PlotWatcher::Stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    m_thread.join();
+#ifdef __linux__
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_watches.clear();
+#endif
+}
+
+PlotChanges PlotWatcher::UpdatePlots(std::vector<std::string> const& add_paths,
+                                     std::vector<std::string> const& remove_paths) {
+    for (auto const& plot_path : remove_paths) {
+        m_rejected.erase(plot_path);
+    }
+    std::vector<std::string> paths_to_add;
+    std::map<std::string, FileStamp> stamps;
+    for (auto const& plot_path : add_paths) {
+        std::error_code ec_size, ec_mtime;
+        FileStamp stamp{fs::file_size(plot_path, ec_size), fs::last_write_time(plot_path, ec_mtime)};
+        auto it = m_rejected.find(plot_path);
+        if (it != std::end(m_rejected)) {
+            if (!ec_size && !ec_mtime && it->second == stamp) {
+                continue;
+            }
+            m_rejected.erase(it);
+        }
+        if (!ec_size && !ec_mtime) {
+            stamps[plot_path] = stamp;
+        }
+        paths_to_add.push_back(plot_path);
+    }
+    if (paths_to_add.empty() && remove_paths.empty()) {
+        return {};
+    }
+    auto changes = m_prover.UpdatePlots(paths_to_add, remove_paths);
+    for (auto const& plot_path : changes.added) {
+        stamps.erase(plot_path);
+    }
+    // The stamps left are of the rejected plots
+    m_rejected.insert(std::begin(stamps), std::end(stamps));
+    return changes;
+}
+
+bool PlotWatcher::IsPlotFile(std::string const& file_path) { return fs::path(file_path).extension() == ".plot"; }
+
+void PlotWatcher::Rescan(std::string const& dir) {
+    std::set<std::string> files;
+    std::error_code ec;
+    for (auto const& entry : fs::directory_iterator(fs::path(dir), ec)) {
+        if (entry.is_regular_file(ec) && IsPlotFile(entry.path().string())) {
+            files.insert(entry.path().string());
+        }
+    }
+    for (auto it = std::begin(m_rejected); it != std::end(m_rejected);) {
+        if (IsInDir(it->first, dir) && files.find(it->first) == std::end(files)) {
+            it = m_rejected.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    std::vector<std::string> remove_paths;
+    for (auto const& plot_path : m_prover.GetPlotPaths()) {
+        if (IsInDir(plot_path, dir) && files.erase(plot_path) == 0) {
+            remove_paths.push_back(plot_path);
+        }
+    }
+    // The plots remain in the set are not loaded, the rejected ones are only tried again after they are changed
+    auto changes = UpdatePlots(std::vector<std::string>(std::begin(files), std::end(files)), remove_paths);
+    int num_added = changes.added.size();
+    int num_removed = changes.removed.size();
+    if (num_added > 0 || num_removed > 0) {
+        PLOGI << tinyformat::format("dir %s is rescanned, %d plot(s) added, %d plot(s) removed, total %d plot(s)", dir,
+                                    num_added, num_removed, m_prover.GetNumOfPlots());
+    }
+}
+
+#ifdef __linux__
+
+bool PlotWatcher::AddWatch(std::string const& dir) {
+    uint32_t const MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF |
+                          IN_UNMOUNT | IN_ONLYDIR;
+    int wd = inotify_add_watch(m_fd, dir.c_str(), MASK);
+    if (wd < 0) {
+        PLOGD << tinyformat::format("cannot watch dir: %s", dir);
+        return false;
+    }
+    m_watches[wd] = dir;
+    PLOGI << tinyformat::format("watching plot dir: %s", dir);
+    return true;
+}
+
+void PlotWatcher::WatchProc() {
+    alignas(inotify_event) char buf[4096];
+    auto last_rescan = std::chrono::steady_clock::now();
+    while (m_running) {
+        if (m_fd < 0 || m_watches.size() < m_dirs.size()) {
+            // Some dirs cannot be watched, check them again after a while, the disk might be replaced
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_rescan >= std::chrono::seconds(RESCAN_INTERVAL_SECS)) {
+                last_rescan = now;
+                for (auto const& dir : m_dirs) {
+                    bool watching = std::any_of(std::begin(m_watches), std::end(m_watches),
+                                                [&dir](auto const& entry) { return entry.second == dir; });
+                    if (watching) {
+                        continue;
+                    }
+                    if (m_fd < 0 || AddWatch(dir)) {
+                        Rescan(dir);
+                    }
+                }
+            }
+        }
+        if (m_fd < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIMEOUT_MILLIS));
+            continue;
+        }
+        pollfd pfd{m_fd, POLLIN, 0};
+        if (poll(&pfd, 1, POLL_TIMEOUT_MILLIS) <= 0) {
+            continue;
+        }
+        ssize_t len = read(m_fd, buf, sizeof(buf));
+        for (char* p = buf; len > 0 && p < buf + len;) {
+            auto const* event = reinterpret_cast<inotify_event const*>(p);
+            p += sizeof(inotify_event) + event->len;
+            auto it = m_watches.find(event->wd);
+            if (it == std::end(m_watches)) {
+                continue;
+            }
+            std::string dir = it->second;
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT | IN_IGNORED)) {
+                FlushEvents();
+                // The dir is gone, all plots from the dir are removed, it will be watched again after it is back
+                PLOGE << tinyformat::format("plot dir is gone: %s", dir);
+                if (!(event->mask & IN_IGNORED)) {
+                    inotify_rm_watch(m_fd, event->wd);
+                }
+                m_watches.erase(it);
+                Rescan(dir);
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+            std::string file_path = (fs::path(dir) / event->name).string();
+            if (!IsPlotFile(file_path)) {
+                continue;
+            }
+            // The last event of a plot wins, the plots of all events read together are updated at once
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                m_pending[file_path] = true;
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                m_pending[file_path] = false;
+            }
+        }
+        FlushEvents();
+    }
+}
+
+void PlotWatcher::FlushEvents() {
+    std::vector<std::string> add_paths, remove_paths;
+    for (auto const& entry : m_pending) {
+        (entry.second ? add_paths : remove_paths).push_back(entry.first);
+    }
+    m_pending.clear();
+    auto changes = UpdatePlots(add_paths, remove_paths);
+    if (changes.added.empty() && changes.removed.empty()) {
+        return;
+    }
+    int num_plots = m_prover.GetNumOfPlots();
+    for (auto const& file_path : changes.added) {
+        PLOGI << tinyformat::format("plot is added: %s, total %d plot(s)", file_path, num_plots);
+    }
+    for (auto const& file_path : changes.removed) {
+        PLOGI << tinyformat::format("plot is removed: %s, total %d plot(s)", file_path, num_plots);
+    }
+}
+
+#else
+
+void PlotWatcher::WatchProc() {
+    auto last_rescan = std::chrono::steady_clock::now();
+    while (m_running) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_rescan >= std::chrono::seconds(RESCAN_INTERVAL_SECS)) {
+            last_rescan = now;
+            for (auto const& dir : m_dirs) {
+                Rescan(dir);
+            }
+        }
+    }
+}
+
+#endif
+
+}  // namespace miner
@@ -0,0 +1,76 @@
+#ifndef DEPINC_MINER_PLOT_WATCHER_H
+#define DEPINC_MINER_PLOT_WATCHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <bhd_types.h>
+
+#include "prover.h"
+
+namespace miner {
+
+/**
+ * @brief Watches the plot dirs and updates the prover when plots are added, replaced or removed, the miner doesn't
+ * need to be restarted
+ *
+ * inotify is used on Linux, a dir which is gone (e.g. the disk is failed or unmounted) is rescanned after it is back.
+ * On other platforms the dirs are rescanned periodically.
+ */
+class PlotWatcher {
+public:
+    PlotWatcher(Prover& prover, std::vector<Path> dirs);
+
+    ~PlotWatcher();
+
+    void Start();
+
+    void Stop();
+
+private:
+    void WatchProc();
+
+    /// Add the plots which are not loaded and remove the plots which are gone from the dir
+    void Rescan(std::string const& dir);
+
+    /**
+     * @brief Add and remove the plots with one update of the prover, a plot which is rejected before is only added
+     * again after it is changed
+     */
+    PlotChanges UpdatePlots(std::vector<std::string> const& add_paths, std::vector<std::string> const& remove_paths);
+
+    static bool IsPlotFile(std::string const& file_path);
+
+    /// The size and the last write time, a rejected plot is only tried again after any of them is changed
+    struct FileStamp {
+        std::uintmax_t size{0};
+        fs::file_time_type mtime;
+
+        bool operator==(FileStamp const& rhs) const { return size == rhs.size && mtime == rhs.mtime; }
+    };
+
+    Prover& m_prover;
+    std::vector<std::string> m_dirs;
+    std::map<std::string, FileStamp> m_rejected;  // plot path -> the stamp when it is rejected
+    std::atomic_bool m_running{false};
+    std::thread m_thread;
+#ifdef __linux__
+    bool AddWatch(std::string const& dir);
+
+    /// Apply the changes of the plots which are read from the inotify events
+    void FlushEvents();
+
+    std::map<std::string, bool> m_pending;  // plot path -> true to add, false to remove
+
+    int m_fd{-1};
+    std::map<int, std::string> m_watches;  // watch descriptor -> dir
+#endif
+};
+
+}  // namespace miner
+
+#endif
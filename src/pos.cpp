@@ -7,18 +7,33 @@
 #include <src/prover_disk.hpp>
 #include <src/verifier.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
 #include "utils.h"
 #include "pos.h"
 
 namespace chiapos {
 
-void InitDecompressorQueueDefault(bool no_cuda, int max_compression_level, int timeout_seconds)
+void InitDecompressorQueueDefault(bool no_cuda, int max_compression_level, int timeout_seconds, int num_contexts,
+                                  int threads_per_context, bool cpu_affinity)
 {
     static bool initialized = false;
     if (initialized) {
         return;
     }
-    decompressor_context_queue.init(1, (uint32_t)std::thread::hardware_concurrency(), false, max_compression_level, !no_cuda, 0, false, timeout_seconds);
+    num_contexts = std::max(num_contexts, 1);
+    if (threads_per_context <= 0) {
+        threads_per_context = std::max((int)std::thread::hardware_concurrency(), 1);
+    }
+    decompressor_context_queue.init(num_contexts, threads_per_context, !cpu_affinity, max_compression_level, !no_cuda, 0, false, timeout_seconds);
+    // A proving thread blocks on a context while decompressing, more threads than contexts only wait
+    InitProvingScheduler(num_contexts);
     initialized = true;
 }
 
@@ -60,69 +75,307 @@ struct GetPubKeyOrHashType {
     PlotPubKeyType operator()(uint256 const&) const { return PlotPubKeyType::PooledPlots; }
 };
 
-struct PlotFileImpl {
+PlotMemo ParseMemo(PlotId const& plotId, Bytes const& memo) {
+    PlotMemo plot_memo;
+    plot_memo.plot_id = MakeBytes(plotId);
+    if (memo.size() == 48 + 48 + 32) {
+        plot_memo.plot_id_type = PlotPubKeyType::OGPlots;
+        plot_memo.pool_pk_or_puzzle_hash = SubBytes(memo, 0, 48);
+        plot_memo.farmer_pk = SubBytes(memo, 48, 48);
+        plot_memo.local_master_sk = SubBytes(memo, 48 + 48);
+    } else if (memo.size() == 32 + 48 + 32) {
+        plot_memo.plot_id_type = PlotPubKeyType::PooledPlots;
+        plot_memo.pool_pk_or_puzzle_hash = SubBytes(memo, 0, 32);
+        plot_memo.farmer_pk = SubBytes(memo, 32, 48);
+        plot_memo.local_master_sk = SubBytes(memo, 32 + 48);
+    }
+    return plot_memo;
+}
+
+/// The opened plots in the order of use, the least recently used ones are closed when there are too many
+class OpenedPlots {
+public:
+    void SetMax(std::size_t max_opened) {
+        std::lock_guard<std::mutex> lg(m_mtx);
+        m_max = max_opened;
+    }
+
+    /// Move the plot to the front, returns the plots should be closed
+    std::vector<std::shared_ptr<PlotFileImpl>> Touch(std::shared_ptr<PlotFileImpl> const& impl) {
+        std::vector<std::shared_ptr<PlotFileImpl>> res;
+        std::lock_guard<std::mutex> lg(m_mtx);
+        if (m_max == 0) {
+            return res;
+        }
+        auto it = m_index.find(impl.get());
+        if (it != std::end(m_index)) {
+            m_lru.splice(std::begin(m_lru), m_lru, it->second);
+        } else {
+            m_lru.push_front(std::make_pair(impl.get(), std::weak_ptr<PlotFileImpl>(impl)));
+            m_index[impl.get()] = std::begin(m_lru);
+        }
+        while (m_lru.size() > m_max) {
+            auto victim = m_lru.back().second.lock();
+            if (victim) {
+                res.push_back(std::move(victim));
+            }
+            m_index.erase(m_lru.back().first);
+            m_lru.pop_back();
+        }
+        return res;
+    }
+
+    void Remove(PlotFileImpl* impl) {
+        std::lock_guard<std::mutex> lg(m_mtx);
+        auto it = m_index.find(impl);
+        if (it != std::end(m_index)) {
+            m_lru.erase(it->second);
+            m_index.erase(it);
+        }
+    }
+
+private:
+    std::mutex m_mtx;
+    std::size_t m_max{0};
+    using Entry = std::pair<PlotFileImpl*, std::weak_ptr<PlotFileImpl>>;
+    std::list<Entry> m_lru;  // the most recently used plot is at the front
+    std::unordered_map<PlotFileImpl*, std::list<Entry>::iterator> m_index;
+};
+
+OpenedPlots& GetOpenedPlots() {
+    static OpenedPlots opened_plots;
+    return opened_plots;
+}
+
+void SetMaxOpenedPlots(std::size_t max_opened) { GetOpenedPlots().SetMax(max_opened); }
+
+/// Runs the proving jobs of the compressed plots, the decompression of a job blocks a thread so the jobs are queued
+/// here by priority and deadline instead of blocking the callers
+class ProvingScheduler {
+public:
+    /// A job is called with `dropped` set when it won't be run
+    using JobFunc = std::function<void(bool dropped)>;
+
+    ~ProvingScheduler() {
+        {
+            std::lock_guard<std::mutex> lg(m_mtx);
+            m_exiting = true;
+        }
+        m_cv.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void SetNumOfThreads(int num_threads) {
+        std::lock_guard<std::mutex> lg(m_mtx);
+        m_num_threads = std::max(num_threads, 1);
+    }
+
+    ProvingTicket Begin(std::chrono::steady_clock::duration budget) {
+        ProvingTicket ticket;
+        ticket.generation = ++m_generation;
+        ticket.deadline = std::chrono::steady_clock::now() + budget;
+        ticket.cancelled = std::make_shared<std::atomic_bool>(false);
+        return ticket;
+    }
+
+    void Submit(ProvingPriority priority, ProvingTicket const& ticket, JobFunc func) {
+        {
+            std::lock_guard<std::mutex> lg(m_mtx);
+            while (static_cast<int>(m_threads.size()) < m_num_threads) {
+                m_threads.emplace_back(&ProvingScheduler::ThreadProc, this);
+            }
+            m_jobs.push(Job{static_cast<int>(priority), ticket, m_next_seq++, std::move(func)});
+        }
+        m_cv.notify_one();
+    }
+
+private:
+    struct Job {
+        int priority;
+        ProvingTicket ticket;
+        uint64_t seq;
+        JobFunc func;
+
+        /// The job with the highest priority, the earliest deadline and the earliest submission is on the top
+        bool operator<(Job const& rhs) const {
+            if (priority != rhs.priority) {
+                return priority > rhs.priority;
+            }
+            if (ticket.deadline != rhs.ticket.deadline) {
+                return ticket.deadline > rhs.ticket.deadline;
+            }
+            return seq > rhs.seq;
+        }
+    };
+
+    bool IsStale(Job const& job) const {
+        return job.ticket.generation < m_generation || std::chrono::steady_clock::now() > job.ticket.deadline ||
+               job.ticket.IsCancelled();
+    }
+
+    void ThreadProc() {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        while (true) {
+            m_cv.wait(lock, [this]() { return m_exiting || !m_jobs.empty(); });
+            if (m_exiting) {
+                break;
+            }
+            Job job = std::move(const_cast<Job&>(m_jobs.top()));
+            m_jobs.pop();
+            bool dropped = IsStale(job);
+            lock.unlock();
+            job.func(dropped);
+            lock.lock();
+        }
+        // Release the callers which are still waiting
+        while (!m_jobs.empty()) {
+            Job job = std::move(const_cast<Job&>(m_jobs.top()));
+            m_jobs.pop();
+            job.func(true);
+        }
+    }
+
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    bool m_exiting{false};
+    int m_num_threads{1};
+    std::vector<std::thread> m_threads;
+    std::priority_queue<Job> m_jobs;
+    uint64_t m_next_seq{0};
+    std::atomic<uint64_t> m_generation{0};
+};
+
+ProvingScheduler& GetProvingScheduler() {
+    static ProvingScheduler scheduler;
+    return scheduler;
+}
+
+void InitProvingScheduler(int num_threads) { GetProvingScheduler().SetNumOfThreads(num_threads); }
+
+ProvingTicket BeginProving(std::chrono::steady_clock::duration budget) { return GetProvingScheduler().Begin(budget); }
+
+struct PlotFileImpl : public std::enable_shared_from_this<PlotFileImpl> {
+    std::string path;
+    PlotHeader header;
+    // The prover is opened on the first query when the plot is made from its header or it has been closed
+    std::mutex proverMtx;
     std::shared_ptr<DiskProver> diskProver;
+    // The memo never changes for a plot, it is parsed once and shared by all copies of the CPlotFile
+    std::mutex memoMtx;
+    optional<PlotMemo> memo;
+
+    ~PlotFileImpl() { GetOpenedPlots().Remove(this); }
+
+    std::shared_ptr<DiskProver> GetProver() {
+        std::shared_ptr<DiskProver> prover;
+        {
+            std::lock_guard<std::mutex> lg(proverMtx);
+            if (diskProver == nullptr) {
+                try {
+                    diskProver = std::make_shared<DiskProver>(path);
+                } catch (std::exception const& e) {
+                    std::cerr << __func__ << ": cannot open plot " << path << ", " << e.what() << std::endl;
+                }
+            }
+            prover = diskProver;
+        }
+        if (prover != nullptr) {
+            MarkUsed();
+        }
+        return prover;
+    }
+
+    /// Put the plot to the front of the opened plots, the least recently used ones are closed
+    void MarkUsed() {
+        // The victims are closed without holding the lock of the opened plots
+        for (auto const& victim : GetOpenedPlots().Touch(shared_from_this())) {
+            victim->Close();
+        }
+    }
+
+    /// Close the prover, the queries in progress still hold the prover until they finish
+    void Close() {
+        std::lock_guard<std::mutex> lg(proverMtx);
+        diskProver.reset();
+    }
 };
 
-CPlotFile::CPlotFile(std::string filePath) : m_path(std::move(filePath)) {
+CPlotFile::CPlotFile(std::string filePath) {
     try {
-        m_impl.reset(new PlotFileImpl{std::make_shared<DiskProver>(m_path)});
+        auto diskProver = std::make_shared<DiskProver>(filePath);
+        m_impl = std::make_shared<PlotFileImpl>();
+        m_impl->path = std::move(filePath);
+        m_impl->header.plot_id = MakeUint256(diskProver->GetId());
+        m_impl->header.k = diskProver->GetSize();
+        m_impl->header.compression_level = diskProver->GetCompressionLevel();
+        m_impl->header.memo = diskProver->GetMemo();
+        m_impl->diskProver = std::move(diskProver);
+        m_impl->MarkUsed();
     } catch (std::exception const& e) {
         m_impl.reset();
     }
 }
 
+CPlotFile::CPlotFile(std::string filePath, PlotHeader header) : m_impl(std::make_shared<PlotFileImpl>()) {
+    m_impl->path = std::move(filePath);
+    m_impl->header = std::move(header);
+}
+
+std::string const& CPlotFile::GetPath() const {
+    static std::string const EMPTY_PATH;
+    if (m_impl == nullptr) {
+        return EMPTY_PATH;
+    }
+    return m_impl->path;
+}
+
+bool CPlotFile::GetHeader(PlotHeader& outHeader) const {
+    if (m_impl == nullptr) {
+        return false;
+    }
+    outHeader = m_impl->header;
+    return true;
+}
+
 PlotId CPlotFile::GetPlotId() const {
     if (m_impl == nullptr) {
         return {};
     }
-    if (m_cached_plotid.IsNull()) {
-        m_cached_plotid = MakeUint256(m_impl->diskProver->GetId());
-    }
-    return m_cached_plotid;
+    return m_impl->header.plot_id;
 }
 
 bool CPlotFile::ReadMemo(PlotMemo& outMemo) const {
     if (m_impl == nullptr) {
         return false;
     }
-    try {
-        Bytes memo = m_impl->diskProver->GetMemo();
-        PlotMemo plot_memo;
-        plot_memo.plot_id = m_impl->diskProver->GetId();
-        if (memo.size() == 48 + 48 + 32) {
-            plot_memo.plot_id_type = PlotPubKeyType::OGPlots;
-            plot_memo.pool_pk_or_puzzle_hash = SubBytes(memo, 0, 48);
-            plot_memo.farmer_pk = SubBytes(memo, 48, 48);
-            plot_memo.local_master_sk = SubBytes(memo, 48 + 48);
-        } else if (memo.size() == 32 + 48 + 32) {
-            plot_memo.plot_id_type = PlotPubKeyType::PooledPlots;
-            plot_memo.pool_pk_or_puzzle_hash = SubBytes(memo, 0, 32);
-            plot_memo.farmer_pk = SubBytes(memo, 32, 48);
-            plot_memo.local_master_sk = SubBytes(memo, 32 + 48);
-        }
-        outMemo = plot_memo;
-        return true;
-    } catch (std::exception const& e) {
-        std::cerr << __func__ << ": " << e.what();
+    std::lock_guard<std::mutex> lg(m_impl->memoMtx);
+    if (!m_impl->memo.has_value()) {
+        m_impl->memo = ParseMemo(m_impl->header.plot_id, m_impl->header.memo);
     }
-    return false;
+    outMemo = *m_impl->memo;
+    return true;
 }
 
 bool CPlotFile::GetQualityString(uint256 const& challenge, std::vector<QualityStringPack>& out) const {
     if (m_impl == nullptr) {
         return false;
     }
+    auto diskProver = m_impl->GetProver();
+    if (diskProver == nullptr) {
+        return false;
+    }
     try {
-        std::vector<LargeBits> qualities = m_impl->diskProver->GetQualitiesForChallenge(challenge.begin());
+        std::vector<LargeBits> qualities = diskProver->GetQualitiesForChallenge(challenge.begin());
         std::vector<QualityStringPack> qs_pack_vec;
         int index{0};
         for (auto const& quality : qualities) {
             QualityStringPack qs_pack;
-            qs_pack.plot_path = m_path;
+            qs_pack.plot_path = m_impl->path;
             Bytes quality_bytes = ToBytes(quality);
             qs_pack.quality_str.FromBytes(quality_bytes, quality.GetSize());
-            qs_pack.k = m_impl->diskProver->GetSize();
+            qs_pack.k = m_impl->header.k;
             qs_pack.index = index++;
             qs_pack_vec.push_back(std::move(qs_pack));
         }
@@ -135,13 +388,42 @@ bool CPlotFile::GetQualityString(uint256 const& challenge, std::vector<QualitySt
     return false;
 }
 
+bool CPlotFile::VisitMixedQualityStrings(uint256 const& challenge, MixedQualityStringVisitor const& visitor) const {
+    if (m_impl == nullptr) {
+        return false;
+    }
+    auto diskProver = m_impl->GetProver();
+    if (diskProver == nullptr) {
+        return false;
+    }
+    std::vector<LargeBits> qualities = diskProver->GetQualitiesForChallenge(challenge.begin());
+    int index{0};
+    for (auto const& quality : qualities) {
+        // The quality string is 256 bits, convert it on stack
+        uint8_t quality_bytes[32];
+        int num_bytes = (quality.GetSize() + 7) / 8;
+        if (num_bytes > static_cast<int>(sizeof(quality_bytes))) {
+            Bytes quality_vec = ToBytes(quality);
+            visitor(index++, GetMixedQualityString(quality_vec, challenge));
+            continue;
+        }
+        quality.ToBytes(quality_bytes);
+        visitor(index++, GetMixedQualityString(quality_bytes, num_bytes, challenge));
+    }
+    return true;
+}
+
 bool CPlotFile::GetFullProof(uint256 const& challenge, int index, Bytes& out) const {
     if (m_impl == nullptr) {
         return false;
     }
+    auto diskProver = m_impl->GetProver();
+    if (diskProver == nullptr) {
+        return false;
+    }
     try {
-        int proof_bytes = (int)m_impl->diskProver->GetSize() * 8;
-        LargeBits proof = m_impl->diskProver->GetFullProof(challenge.begin(), index);
+        int proof_bytes = (int)m_impl->header.k * 8;
+        LargeBits proof = diskProver->GetFullProof(challenge.begin(), index);
         Bytes proof_data(proof_bytes);
         proof.ToBytes(proof_data.data());
         out = proof_data;
@@ -152,7 +434,52 @@ bool CPlotFile::GetFullProof(uint256 const& challenge, int index, Bytes& out) co
     return false;
 }
 
-uint8_t CPlotFile::GetK() const { return m_impl->diskProver->GetSize(); }
+std::future<optional<std::vector<uint256>>> CPlotFile::AsyncGetMixedQualityStrings(
+        uint256 const& challenge, ProvingTicket const& ticket) const {
+    auto promise = std::make_shared<std::promise<optional<std::vector<uint256>>>>();
+    auto res = promise->get_future();
+    GetProvingScheduler().Submit(ProvingPriority::Quality, ticket, [plot = *this, challenge, promise](bool dropped) {
+        if (dropped) {
+            promise->set_value({});
+            return;
+        }
+        try {
+            std::vector<uint256> mixed_quality_strings;
+            bool succ = plot.VisitMixedQualityStrings(
+                    challenge, [&mixed_quality_strings](int, uint256 const& mixed_quality_string) {
+                        mixed_quality_strings.push_back(mixed_quality_string);
+                    });
+            if (succ) {
+                promise->set_value(std::move(mixed_quality_strings));
+            } else {
+                promise->set_value({});
+            }
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return res;
+}
+
+std::future<optional<Bytes>> CPlotFile::AsyncGetFullProof(uint256 const& challenge, int index,
+                                                          ProvingTicket const& ticket) const {
+    auto promise = std::make_shared<std::promise<optional<Bytes>>>();
+    auto res = promise->get_future();
+    GetProvingScheduler().Submit(ProvingPriority::FullProof, ticket,
+                                 [plot = *this, challenge, index, promise](bool dropped) {
+                                     Bytes proof;
+                                     if (!dropped && plot.GetFullProof(challenge, index, proof)) {
+                                         promise->set_value(std::move(proof));
+                                     } else {
+                                         promise->set_value({});
+                                     }
+                                 });
+    return res;
+}
+
+uint8_t CPlotFile::GetK() const { return m_impl->header.k; }
+
+uint8_t CPlotFile::GetCompressionLevel() const { return m_impl->header.compression_level; }
 
 Bytes ToBytes(PubKeyOrHash const& val) { return std::visit(MakePubKeyOrHashBytes(), val); }
 
@@ -170,7 +497,7 @@ std::string TypeToString(PlotPubKeyType type) {
 
 CKey GenerateTapRootSk(PubKey const& localPk, PubKey const& farmerPk) {
     PubKey aggPk = AggregatePubkeys({localPk, farmerPk});
-    Bytes vchSeed = MakeSHA256(BytesConnector::Connect(MakeBytes(aggPk), MakeBytes(localPk), MakeBytes(farmerPk)));
+    Bytes vchSeed = MakeSHA256(aggPk, localPk, farmerPk);
     return CKey::CreateKeyWithRandomSeed(vchSeed);
 }
 
@@ -203,7 +530,7 @@ PubKeyOrHash MakePubKeyOrHash(PlotPubKeyType type, Bytes const& vchData) {
 }
 
 PlotId MakePlotId(Bytes const& poolPk, PubKey const& plotPk) {
-    return MakeUint256(MakeSHA256(BytesConnector::Connect(poolPk, plotPk)));
+    return MakeUint256(MakeSHA256Digest(poolPk, plotPk));
 }
 
 PlotId MakePlotId(PubKey const& localPk, PubKey const& farmerPk, PubKeyOrHash const& poolPkOrHash) {
@@ -213,9 +540,10 @@ PlotId MakePlotId(PubKey const& localPk, PubKey const& farmerPk, PubKeyOrHash co
 
 uint256 MakeMixedQualityString(PlotId const& plotId, uint8_t k, uint256 const& challenge, Bytes const& vchProof) {
     Verifier verifier;
-    Bytes plot_id_bytes = MakeBytes(plotId);
+    uint8_t plot_id_bytes[32];
+    WriteUint256Bytes(plotId, plot_id_bytes);
     LargeBits quality_string_bits =
-            verifier.ValidateProof(plot_id_bytes.data(), k, challenge.begin(), vchProof.data(), vchProof.size());
+            verifier.ValidateProof(plot_id_bytes, k, challenge.begin(), vchProof.data(), vchProof.size());
     Bytes quality_string = ToBytes(quality_string_bits);
     if (quality_string.empty()) {
         return uint256();
@@ -230,18 +558,23 @@ uint256 MakeMixedQualityString(PubKey const& localPk, PubKey const& farmerPk, Pu
 }
 
 bool PassesFilter(PlotId const& plotId, uint256 const& challenge, int bits) {
-    int const BYTES_uint256 = 32;
-    Bytes data(BYTES_uint256 * 2);
-    memcpy(data.data(), plotId.begin(), BYTES_uint256);
-    memcpy(data.data() + BYTES_uint256, challenge.begin(), BYTES_uint256);
-    Bytes data_hashed = MakeSHA256(data);
-    auto res = MakeUint256(data_hashed);
-    auto res_filter = UintToArith256(res) >> (256 - bits);
-    return res_filter == 0;
+    sha256::Digest data_hashed = MakeSHA256Digest(plotId, challenge);
+    // The hash is compared as a big-endian number, the leading bits must be zero
+    int i{0};
+    for (; bits >= 8; bits -= 8) {
+        if (data_hashed[i++] != 0) {
+            return false;
+        }
+    }
+    return bits == 0 || (data_hashed[i] >> (8 - bits)) == 0;
 }
 
 uint256 GetMixedQualityString(Bytes const& quality_string, uint256 const& challenge) {
-    return MakeUint256(MakeSHA256(quality_string, challenge));
+    return MakeUint256(MakeSHA256Digest(quality_string, challenge));
+}
+
+uint256 GetMixedQualityString(uint8_t const* quality_string, size_t size, uint256 const& challenge) {
+    return MakeUint256(sha256::Hasher().Write(quality_string, size).Write(challenge.begin(), challenge.size()).Finalize());
 }
 
 bool VerifyPos(uint256 const& challenge, PubKey const& localPk, PubKey const& farmerPk,
@@ -4,6 +4,11 @@
 #include <chiapos_types.h>
 #include <uint256.h>
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
 #include <variant>
 #include <string>
 #include <vector>
@@ -12,7 +17,57 @@
 
 namespace chiapos {
 
-void InitDecompressorQueueDefault(bool no_cuda = false, int max_compression_level = 9, int timeout_seconds = 30);
+/**
+ * @brief Initialize the decompressor contexts for the compressed plots, it only works on the first call
+ *
+ * @param num_contexts The number of the decompressor contexts, the compressed plots are decompressed at the same time
+ * by this number of proving threads
+ * @param threads_per_context 0 to use all CPUs for each context
+ * @param cpu_affinity Pin the threads of the context `i` to the CPUs [i * threads_per_context, (i + 1) *
+ * threads_per_context), the context queue cannot pin any other ranges, see `MakeCpuLayout`
+ */
+void InitDecompressorQueueDefault(bool no_cuda = false, int max_compression_level = 9, int timeout_seconds = 30,
+                                  int num_contexts = 1, int threads_per_context = 0, bool cpu_affinity = true);
+
+/// Keep at most `max_opened` plots opened, the least recently used plots are closed and opened again on demand, 0 to
+/// keep all plots opened
+void SetMaxOpenedPlots(std::size_t max_opened);
+
+/// The proving jobs of the compressed plots are run by the order of the priority, then by the deadline
+enum class ProvingPriority : int { FullProof = 0, Quality = 1 };
+
+/// The proving jobs submitted for a challenge, a job is dropped without running when its deadline is passed, the
+/// proving of a newer challenge is started or the ticket is cancelled
+struct ProvingTicket {
+    uint64_t generation{0};
+    std::chrono::steady_clock::time_point deadline{std::chrono::steady_clock::time_point::max()};
+    std::shared_ptr<std::atomic_bool> cancelled;  // shared by all copies of the ticket
+    std::shared_ptr<std::atomic_bool> parent_cancelled;  // the flag of the ticket this one is made from
+
+    /// Cancel the proving, it can be called from any thread
+    void Cancel() const {
+        if (cancelled) {
+            *cancelled = true;
+        }
+    }
+
+    bool IsCancelled() const { return (cancelled && *cancelled) || (parent_cancelled && *parent_cancelled); }
+
+    /// Make a ticket of the same proving which can be cancelled alone, it is cancelled with this ticket too
+    ProvingTicket MakeChild() const {
+        ProvingTicket child = *this;
+        child.cancelled = std::make_shared<std::atomic_bool>(false);
+        child.parent_cancelled = cancelled;
+        return child;
+    }
+};
+
+/// Set the number of threads to run the proving jobs, the threads are started on the first job
+void InitProvingScheduler(int num_threads);
+
+/// Start the proving of a new challenge which should be answered in `budget`, the queued jobs of the previous
+/// challenges are dropped
+ProvingTicket BeginProving(std::chrono::steady_clock::duration budget);
 
 struct LargeBitsImpl;
 
@@ -38,6 +93,16 @@ struct PlotMemo {
     Bytes local_master_sk;
 };
 
+using PlotId = uint256;
+
+/// The header of a plot, the plot can be filtered and its memo can be read without opening it
+struct PlotHeader {
+    PlotId plot_id;
+    uint8_t k{0};
+    uint8_t compression_level{0};
+    Bytes memo;
+};
+
 struct QualityStringPack {
     std::string plot_path;
     chiapos::LargeBitsDummy quality_str;
@@ -47,30 +112,54 @@ struct QualityStringPack {
 
 struct PlotFileImpl;
 
+using MixedQualityStringVisitor = std::function<void(int index, uint256 const& mixed_quality_string)>;
+
 using PubKeyOrHash = std::variant<PubKey, uint256>;
-using PlotId = uint256;
 
 class CPlotFile {
 public:
+    CPlotFile() = default;
+
     explicit CPlotFile(std::string filePath);
 
+    /// Make the plot from its header, the plot file is opened on the first query
+    CPlotFile(std::string filePath, PlotHeader header);
+
     bool IsReady() const { return m_impl != nullptr; }
 
+    bool GetHeader(PlotHeader& outHeader) const;
+
     PlotId GetPlotId() const;
 
+    /// Read the memo from the plot, it is cached after the first successful read
     bool ReadMemo(PlotMemo& outMemo) const;
 
     bool GetQualityString(uint256 const& challenge, std::vector<QualityStringPack>& out) const;
 
+    /// Read the qualities of the challenge and pass them to the visitor after mixing, no quality pack is made
+    bool VisitMixedQualityStrings(uint256 const& challenge, MixedQualityStringVisitor const& visitor) const;
+
     bool GetFullProof(uint256 const& challenge, int index, Bytes& out) const;
 
-    std::string GetPath() const { return m_path; }
+    /// Read the mixed quality strings by the order of their indexes on the proving scheduler, empty when the job is
+    /// dropped or the plot cannot be read
+    std::future<optional<std::vector<uint256>>> AsyncGetMixedQualityStrings(uint256 const& challenge,
+                                                                           ProvingTicket const& ticket) const;
+
+    /// Read the full proof on the proving scheduler, it is run before the quality jobs, empty when the job is dropped
+    /// or the proof cannot be read
+    std::future<optional<Bytes>> AsyncGetFullProof(uint256 const& challenge, int index,
+                                                   ProvingTicket const& ticket) const;
+
+    std::string const& GetPath() const;
 
     uint8_t GetK() const;
 
+    /// The compression level of the plot, 0 for an uncompressed plot
+    uint8_t GetCompressionLevel() const;
+
 private:
-    std::string m_path;
-    mutable uint256 m_cached_plotid;
+    // The plot is shared by all copies, a copy is as cheap as a pointer
     std::shared_ptr<PlotFileImpl> m_impl;
 };
 
@@ -101,6 +190,8 @@ bool PassesFilter(PlotId const& plotId, uint256 const& challenge, int bits);
  */
 uint256 GetMixedQualityString(Bytes const& quality_string, uint256 const& challenge);
 
+uint256 GetMixedQualityString(uint8_t const* quality_string, size_t size, uint256 const& challenge);
+
 bool VerifyPos(uint256 const& challenge, PubKey const& localPk, PubKey const& farmerPk,
                PubKeyOrHash const& poolPkOrHash, uint8_t k, Bytes const& vchProof, uint256* out_mixed_quality_string,
                int bits_of_filter);
@@ -0,0 +1,54 @@
+#include "proof_store.h"
+
+#include <algorithm>
+
+namespace miner {
+
+ProofStore::ProofStore(std::size_t max_challenges)
+        : m_max_challenges(std::max<std::size_t>(max_challenges, 1)), m_table(std::make_shared<Table>()) {}
+
+bool ProofStore::Save(uint256 const& challenge, ProofDetail const& detail) {
+    std::lock_guard<std::mutex> lg(m_mtx_write);
+    auto table = std::make_shared<Table>(*Load());
+    auto proofs = std::make_shared<Proofs>();
+    auto it = table->proofs.find(challenge);
+    if (it != std::end(table->proofs)) {
+        *proofs = *it->second;
+    } else {
+        table->challenges.push_back(challenge);
+    }
+    auto pos = std::lower_bound(std::begin(*proofs), std::end(*proofs), detail.iters,
+                                [](ProofDetail const& lhs, uint64_t value) { return lhs.iters < value; });
+    if (pos != std::end(*proofs) && pos->iters == detail.iters) {
+        return false;
+    }
+    proofs->insert(pos, detail);
+    table->proofs[challenge] = std::move(proofs);
+    while (table->challenges.size() > m_max_challenges) {
+        table->proofs.erase(table->challenges.front());
+        table->challenges.pop_front();
+    }
+    std::atomic_store(&m_table, std::shared_ptr<Table const>(std::move(table)));
+    return true;
+}
+
+chiapos::optional<ProofDetail> ProofStore::Query(uint256 const& challenge, uint64_t iters) const {
+    auto table = Load();
+    auto it = table->proofs.find(challenge);
+    if (it == std::end(table->proofs)) {
+        return {};
+    }
+    Proofs const& proofs = *it->second;
+    auto pos = std::lower_bound(std::begin(proofs), std::end(proofs), iters,
+                                [](ProofDetail const& lhs, uint64_t value) { return lhs.iters < value; });
+    if (pos == std::end(proofs)) {
+        return {};
+    }
+    return *pos;
+}
+
+std::size_t ProofStore::GetNumOfChallenges() const { return Load()->proofs.size(); }
+
+std::shared_ptr<ProofStore::Table const> ProofStore::Load() const { return std::atomic_load(&m_table); }
+
+}  // namespace miner
@@ -0,0 +1,56 @@
+#ifndef DEPINC_MINER_PROOF_STORE_H
+#define DEPINC_MINER_PROOF_STORE_H
+
+#include <chiapos_types.h>
+#include <uint256.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "timelord_client.h"
+
+namespace miner {
+
+/**
+ * @brief The VDF proofs received from the timelords, only the proofs of the latest challenges are kept
+ *
+ * The proofs of a challenge are sorted by iters. A write makes a new copy of the table and publishes it atomically,
+ * so the readers never wait for a write and never see a table that is being changed. The readers only take the short
+ * lock of the atomic shared_ptr (a small mutex pool in libstdc++), never the writer mutex.
+ */
+class ProofStore {
+public:
+    explicit ProofStore(std::size_t max_challenges);
+
+    /// Save the proof, returns false when a proof of the challenge with the same iters is already saved
+    bool Save(uint256 const& challenge, ProofDetail const& detail);
+
+    /// Find the proof with the least iters which is not less than `iters`
+    chiapos::optional<ProofDetail> Query(uint256 const& challenge, uint64_t iters) const;
+
+    /// The number of the challenges which have proofs
+    std::size_t GetNumOfChallenges() const;
+
+private:
+    using Proofs = std::vector<ProofDetail>;
+
+    struct Table {
+        std::map<uint256, std::shared_ptr<Proofs const>> proofs;
+        std::deque<uint256> challenges;  // in the order they are saved, the oldest one is evicted first
+    };
+
+    std::shared_ptr<Table const> Load() const;
+
+    std::size_t m_max_challenges;
+    std::mutex m_mtx_write;  // the writers are serialized
+    std::shared_ptr<Table const> m_table;  // accessed by std::atomic_load/std::atomic_store only
+};
+
+}  // namespace miner
+
+#endif
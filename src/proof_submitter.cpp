@@ -0,0 +1,85 @@
+#include "proof_submitter.h"
+
+#include <plog/Log.h>
+
+namespace miner {
+
+static std::size_t const MAX_SUBMIT_HISTORY = 64;
+
+ProofSubmitter::ProofSubmitter(RPCClient& client) : m_client(client) {}
+
+ProofSubmitter::~ProofSubmitter() { Stop(); }
+
+void ProofSubmitter::SetSubmittedHandler(SubmittedHandler handler) { m_submitted_handler = std::move(handler); }
+
+void ProofSubmitter::Start() {
+    if (m_running.exchange(true)) {
+        return;
+    }
+    m_thread = std::thread(&ProofSubmitter::SubmitProc, this);
+}
+
+void ProofSubmitter::Stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+void ProofSubmitter::Submit(uint256 const& challenge, RPCClient::ProofPack proof_pack) {
+    {
+        std::lock_guard<std::mutex> lg(m_mtx);
+        if (m_pending.find(challenge) != std::end(m_pending) ||
+            m_submit_history.find(challenge) != std::end(m_submit_history)) {
+            return;
+        }
+        m_pending.insert(challenge);
+        m_queue.push_back(std::make_pair(challenge, std::move(proof_pack)));
+    }
+    m_cv.notify_one();
+}
+
+bool ProofSubmitter::IsSubmitted(uint256 const& challenge) const {
+    std::lock_guard<std::mutex> lg(m_mtx);
+    return m_pending.find(challenge) != std::end(m_pending) ||
+           m_submit_history.find(challenge) != std::end(m_submit_history);
+}
+
+void ProofSubmitter::SubmitProc() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        m_cv.wait(lock, [this]() { return !m_running || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            // not running and nothing left
+            break;
+        }
+        auto entry = std::move(m_queue.front());
+        m_queue.pop_front();
+        lock.unlock();
+        bool submitted{false};
+        try {
+            m_client.SubmitProof(entry.second);
+            submitted = true;
+            PLOG_INFO << "$$$$$ Proofs have been submitted $$$$$";
+        } catch (std::exception const& e) {
+            PLOG_ERROR << "SubmitProof throws an exception: " << e.what();
+        }
+        lock.lock();
+        m_pending.erase(entry.first);
+        if (submitted && m_submit_history.insert(entry.first).second) {
+            m_submit_order.push_back(entry.first);
+            if (m_submit_order.size() > MAX_SUBMIT_HISTORY) {
+                m_submit_history.erase(m_submit_order.front());
+                m_submit_order.pop_front();
+            }
+        }
+        if (m_submitted_handler) {
+            lock.unlock();
+            m_submitted_handler(entry.first, submitted);
+            lock.lock();
+        }
+    }
+}
+
+}  // namespace miner
@@ -0,0 +1,62 @@
+#ifndef DEPINC_MINER_PROOF_SUBMITTER_H
+#define DEPINC_MINER_PROOF_SUBMITTER_H
+
+#include <uint256.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "rpc_client.h"
+
+namespace miner {
+
+/**
+ * @brief Submits the proofs on a background thread, the miner goes on with the next challenge while the proof of the
+ * previous one is being submitted
+ */
+class ProofSubmitter {
+public:
+    /// Called on the submitting thread after a proof is submitted, `succ` is false when the node rejects it or the
+    /// network fails, the challenge is no longer treated as submitted then
+    using SubmittedHandler = std::function<void(uint256 const& challenge, bool succ)>;
+
+    explicit ProofSubmitter(RPCClient& client);
+
+    ~ProofSubmitter();
+
+    void SetSubmittedHandler(SubmittedHandler handler);
+
+    void Start();
+
+    /// Stop after the queued proofs are submitted
+    void Stop();
+
+    /// Queue the proof of the challenge, it is ignored when a proof of the challenge is queued or submitted
+    void Submit(uint256 const& challenge, RPCClient::ProofPack proof_pack);
+
+    /// A proof of the challenge is queued, being submitted or submitted successfully
+    bool IsSubmitted(uint256 const& challenge) const;
+
+private:
+    void SubmitProc();
+
+    RPCClient& m_client;
+    SubmittedHandler m_submitted_handler;
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::deque<std::pair<uint256, RPCClient::ProofPack>> m_queue;
+    std::set<uint256> m_pending;  // the challenges which are queued or being submitted
+    std::set<uint256> m_submit_history;  // only the latest challenges are kept
+    std::deque<uint256> m_submit_order;
+    std::atomic_bool m_running{false};
+    std::thread m_thread;
+};
+
+}  // namespace miner
+
+#endif
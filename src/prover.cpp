@@ -1,6 +1,7 @@
 #include "prover.h"
 
 #include <calc_diff.h>
+#include <plot_cache.h>
 #include <pos.h>
 #include <utils.h>
 #include <bls_key.h>
@@ -9,11 +10,19 @@
 #include <tinyformat.h>
 
 #include <algorithm>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
 
 #ifdef _WIN32
 
 #include <windows.h>
 
+#else
+
+#include <sys/stat.h>
+
 #endif
 
 namespace miner {
@@ -99,6 +108,26 @@ std::tuple<std::vector<std::string>, uint64_t> EnumPlotsFromDir(std::string cons
     });
 }
 
+#ifdef _WIN32
+
+DiskId GetDiskId(std::string const& file_path) {
+    // Use the volume the file is stored on, plots from the same drive letter are grouped together
+    return std::hash<std::string>()(fs::absolute(Path(file_path)).root_name().string());
+}
+
+#else
+
+DiskId GetDiskId(std::string const& file_path) {
+    struct stat st;
+    if (stat(file_path.c_str(), &st) != 0) {
+        PLOGE << tinyformat::format("cannot stat file: %s, it will be scanned with plots from unknown disk", file_path);
+        return 0;
+    }
+    return static_cast<DiskId>(st.st_dev);
+}
+
+#endif
+
 std::vector<Path> StrListToPathList(std::vector<std::string> const& str_list) {
     std::vector<Path> path_list;
     std::transform(std::begin(str_list), std::end(str_list), std::back_inserter(path_list),
@@ -106,37 +135,127 @@ std::vector<Path> StrListToPathList(std::vector<std::string> const& str_list) {
     return path_list;
 }
 
-Prover::Prover(std::vector<Path> const& path_list, std::vector<uint8_t> const& allowed_k_vec) {
-    CSHA256 generator;
+namespace {
+
+/// Run `func` with the plot indexes of each disk on its own worker, the results are returned in the order of disks
+template <typename Func>
+auto RunOnDisks(std::vector<std::vector<std::size_t>> const& disk_plots, Func func)
+        -> std::vector<decltype(func(disk_plots.front()))> {
+    using Result = decltype(func(disk_plots.front()));
+    std::vector<Result> res;
+    if (disk_plots.size() == 1) {
+        // Only one disk is involved, no reason to start a worker
+        res.push_back(func(disk_plots.front()));
+        return res;
+    }
+    std::vector<std::future<Result>> workers;
+    workers.reserve(disk_plots.size());
+    for (auto const& plot_indexes : disk_plots) {
+        workers.push_back(std::async(std::launch::async, func, std::cref(plot_indexes)));
+    }
+    for (auto& worker : workers) {
+        // `get` rethrows the exception raised from the worker
+        res.push_back(worker.get());
+    }
+    return res;
+}
+
+}  // namespace
+
+Prover::Prover(std::vector<Path> const& path_list, std::vector<uint8_t> const& allowed_k_vec,
+               std::string const& cache_path)
+        : m_allowed_k_vec(allowed_k_vec) {
     PLOGI << tinyformat::format("total %d paths found from config", path_list.size());
+    struct PlotEntry {
+        std::string path;
+        DiskId disk_id;
+        uint64_t size{0};
+        int64_t mtime{0};
+        chiapos::CPlotFile plot_file;
+        bool bad{false};
+        bool stamped{false};  // the size and the mtime are read, the plot can be found from or saved to the cache
+    };
+    std::vector<PlotEntry> entries;
+    std::map<DiskId, std::vector<std::size_t>> disk_entries;
     for (auto const& path : path_list) {
         std::vector<std::string> files;
-        uint64_t total_size;
-        std::tie(files, total_size) = EnumPlotsFromDir(path.string());
-        m_total_size += total_size;
+        std::tie(files, std::ignore) = EnumPlotsFromDir(path.string());
         for (auto const& file : files) {
-            chiapos::CPlotFile plotFile(file);
-            if (plotFile.IsReady()) {
-                bool allowed{true};
-                if (!allowed_k_vec.empty()) {
-                    auto it = std::find(std::begin(allowed_k_vec), std::end(allowed_k_vec), plotFile.GetK());
-                    allowed = it != std::end(allowed_k_vec);
-                }
-                if (allowed) {
-                    PLOGD << tinyformat::format("Add plot, k=%d, path=%s", (int)plotFile.GetK(), file);
-                    auto plot_id = plotFile.GetPlotId();
-                    generator.Write(plot_id.begin(), plot_id.size());
-                    m_plotter_files.push_back(std::move(plotFile));
+            DiskId disk_id = GetDiskId(file);
+            disk_entries[disk_id].push_back(entries.size());
+            entries.push_back(PlotEntry{file, disk_id});
+        }
+    }
+    PlotHeaderCache cache(cache_path);
+    if (!cache_path.empty() && cache.Load()) {
+        PLOGI << tinyformat::format("%d plot header(s) are loaded from cache: %s", cache.Size(), cache_path);
+    }
+    // Each disk is loaded by its own worker, the plots are read from the cache when they are not changed
+    std::vector<std::vector<std::size_t>> disk_plots;
+    for (auto& entry : disk_entries) {
+        disk_plots.push_back(std::move(entry.second));
+    }
+    auto cache_hits = RunOnDisks(disk_plots, [this, &entries, &cache](std::vector<std::size_t> const& indexes) {
+        int hits{0};
+        for (std::size_t i : indexes) {
+            PlotEntry& entry = entries[i];
+            std::error_code ec_size, ec_mtime;
+            uint64_t size = fs::file_size(entry.path, ec_size);
+            auto mtime = fs::last_write_time(entry.path, ec_mtime);
+            entry.stamped = !ec_size && !ec_mtime;
+            if (!ec_size) {
+                entry.size = size;
+            }
+            if (!ec_mtime) {
+                entry.mtime = mtime.time_since_epoch().count();
+            }
+            chiapos::optional<chiapos::PlotHeader> header;
+            if (entry.stamped) {
+                header = cache.Find(entry.path, entry.size, entry.mtime);
+            }
+            if (header.has_value()) {
+                ++hits;
+                if (IsAllowedK(header->k)) {
+                    entry.plot_file = chiapos::CPlotFile(entry.path, std::move(*header));
                 }
             } else {
-                m_total_size -= fs::file_size(file);
-                PLOG_ERROR << "bad plot: " << file;
+                entry.plot_file = OpenPlot(entry.path, &entry.bad);
             }
         }
+        return hits;
+    });
+    PlotHeaderCache updated_cache(cache_path);
+    for (auto& entry : entries) {
+        if (!entry.bad) {
+            m_total_size += entry.size;
+        }
+        if (!entry.plot_file.IsReady()) {
+            continue;
+        }
+        if (entry.stamped) {
+            chiapos::PlotHeader header;
+            entry.plot_file.GetHeader(header);
+            updated_cache.Put(entry.path, entry.size, entry.mtime, std::move(header));
+        }
+        PLOGD << tinyformat::format("Add plot, k=%d, path=%s", (int)entry.plot_file.GetK(), entry.path);
+        m_plots.Add(std::move(entry.plot_file), entry.size, entry.disk_id);
+    }
+    m_group_hash = m_plots.CalculateGroupHash();
+    int num_cache_hits{0};
+    for (int hits : cache_hits) {
+        num_cache_hits += hits;
     }
-    generator.Finalize(m_group_hash.begin());
-    PLOG_INFO << "found total " << m_plotter_files.size() << " plots, group hash: " << m_group_hash.GetHex()
+    if (!cache_path.empty() && updated_cache.Save()) {
+        PLOGI << tinyformat::format("%d plot(s) are loaded from cache, %d plot header(s) are saved to: %s",
+                                    num_cache_hits, updated_cache.Size(), cache_path);
+    }
+    PLOG_INFO << "found total " << m_plots.Size() << " plots on " << GetNumOfDisks()
+              << " disk(s), group hash: " << m_group_hash.GetHex()
               << ", total size: " << chiapos::MakeNumberStr(m_total_size);
+    for (auto const& group : m_plots.GetFarmerGroups()) {
+        PLOG_INFO << tinyformat::format("farmer %s: %d plot(s), size: %s", chiapos::BytesToHex(group.farmer_pk),
+                                        group.num_plots, chiapos::MakeNumberStr(group.total_size));
+    }
     if (!allowed_k_vec.empty()) {
         std::stringstream ss;
         for (auto k : allowed_k_vec) {
@@ -146,35 +265,257 @@ Prover::Prover(std::vector<Path> const& path_list, std::vector<uint8_t> const& a
     }
 }
 
+int Prover::GetNumOfPlots() const {
+    std::shared_lock<std::shared_mutex> lock(m_mtx);
+    return m_plots.GetNumOfActivePlots();
+}
+
+int Prover::GetNumOfDisks() const {
+    std::shared_lock<std::shared_mutex> lock(m_mtx);
+    std::set<DiskId> disks;
+    for (std::size_t i = 0; i < m_plots.Size(); ++i) {
+        if (!m_plots.IsRevoked(i)) {
+            disks.insert(m_plots.GetDiskId(i));
+        }
+    }
+    return disks.size();
+}
+
+std::vector<FarmerGroup> Prover::GetFarmerGroups() const {
+    std::shared_lock<std::shared_mutex> lock(m_mtx);
+    return m_plots.GetFarmerGroups();
+}
+
+std::vector<std::string> Prover::GetPlotPaths() const {
+    std::shared_lock<std::shared_mutex> lock(m_mtx);
+    std::vector<std::string> res;
+    res.reserve(m_plots.Size());
+    for (std::size_t i = 0; i < m_plots.Size(); ++i) {
+        res.push_back(m_plots.GetPlotFile(i).GetPath());
+    }
+    return res;
+}
+
+bool Prover::AddPlot(std::string const& file_path) { return !UpdatePlots({file_path}, {}).added.empty(); }
+
+bool Prover::RemovePlot(std::string const& file_path) { return !UpdatePlots({}, {file_path}).removed.empty(); }
+
+PlotChanges Prover::UpdatePlots(std::vector<std::string> const& add_paths,
+                                std::vector<std::string> const& remove_paths) {
+    struct OpenedPlot {
+        chiapos::CPlotFile plot_file;
+        uint64_t file_size{0};
+        DiskId disk_id{0};
+        bool ready{false};
+    };
+    // Open the plots before locking, the queries are not blocked by the disk reading
+    std::vector<OpenedPlot> opened_plots;
+    opened_plots.reserve(add_paths.size());
+    for (auto const& file_path : add_paths) {
+        OpenedPlot opened;
+        opened.plot_file = OpenPlot(file_path);
+        std::error_code ec;
+        opened.file_size = fs::file_size(file_path, ec);
+        opened.disk_id = GetDiskId(file_path);
+        opened.ready = opened.plot_file.IsReady() && !ec;
+        opened_plots.push_back(std::move(opened));
+    }
+    PlotChanges changes;
+    std::unique_lock<std::shared_mutex> lock(m_mtx);
+    for (auto const& file_path : remove_paths) {
+        std::size_t plot_index = m_plots.Find(file_path);
+        if (plot_index == PlotRegistry::npos) {
+            continue;
+        }
+        PLOGD << tinyformat::format("Remove plot, path=%s", file_path);
+        m_plots.Erase(plot_index);
+        changes.removed.push_back(file_path);
+    }
+    for (std::size_t i = 0; i < add_paths.size(); ++i) {
+        std::string const& file_path = add_paths[i];
+        std::size_t plot_index = m_plots.Find(file_path);
+        if (plot_index != PlotRegistry::npos) {
+            PLOGI << tinyformat::format("reload plot: %s", file_path);
+            m_plots.Erase(plot_index);
+        }
+        OpenedPlot& opened = opened_plots[i];
+        if (opened.ready) {
+            PLOGD << tinyformat::format("Add plot, k=%d, path=%s", (int)opened.plot_file.GetK(), file_path);
+            m_plots.Add(std::move(opened.plot_file), opened.file_size, opened.disk_id);
+            changes.added.push_back(file_path);
+        }
+    }
+    return changes;
+}
+
+chiapos::CPlotFile Prover::OpenPlot(std::string const& file_path, bool* out_bad) const {
+    chiapos::CPlotFile plot_file(file_path);
+    if (out_bad) {
+        *out_bad = !plot_file.IsReady();
+    }
+    if (!plot_file.IsReady()) {
+        PLOG_ERROR << "bad plot: " << file_path;
+        return {};
+    }
+    if (!IsAllowedK(plot_file.GetK())) {
+        PLOGD << tinyformat::format("k=%d isn't allowed, skip plot: %s", (int)plot_file.GetK(), file_path);
+        return {};
+    }
+    return plot_file;
+}
+
+bool Prover::IsAllowedK(uint8_t k) const {
+    return m_allowed_k_vec.empty() ||
+           std::find(std::begin(m_allowed_k_vec), std::end(m_allowed_k_vec), k) != std::end(m_allowed_k_vec);
+}
+
+namespace {
+
+bool CompareCandidates(QualityCandidate const& lhs, QualityCandidate const& rhs) { return lhs.iters < rhs.iters; }
+
+/// Keep the `max_candidates` candidates with the least iters in a max-heap of iters, the worst kept candidate is at the
+/// front and it is evicted by a better one when the heap is full
+void PushCandidate(std::vector<QualityCandidate>& heap, std::size_t max_candidates, QualityCandidate const& candidate) {
+    if (heap.size() < max_candidates) {
+        heap.push_back(candidate);
+        std::push_heap(std::begin(heap), std::end(heap), CompareCandidates);
+    } else if (candidate.iters < heap.front().iters) {
+        std::pop_heap(std::begin(heap), std::end(heap), CompareCandidates);
+        heap.back() = candidate;
+        std::push_heap(std::begin(heap), std::end(heap), CompareCandidates);
+    }
+}
+
+}  // namespace
+
+std::vector<std::vector<std::size_t>> Prover::GroupPassedPlotsByDisk(uint256 const& challenge,
+                                                                     int bits_of_filter) const {
+    std::map<DiskId, std::vector<std::size_t>> disk_plots;
+    for (std::size_t i : m_plots.Filter(challenge, bits_of_filter)) {
+        PLOG_DEBUG << "passed for plot-id: " << m_plots.GetPlotFile(i).GetPlotId().GetHex()
+                   << ", challenge: " << challenge.GetHex();
+        disk_plots[m_plots.GetDiskId(i)].push_back(i);
+    }
+    std::vector<std::vector<std::size_t>> res;
+    res.reserve(disk_plots.size());
+    for (auto& entry : disk_plots) {
+        res.push_back(std::move(entry.second));
+    }
+    return res;
+}
+
 std::vector<chiapos::QualityStringPack> Prover::GetQualityStrings(uint256 const& challenge, int bits_of_filter) const {
+    std::shared_lock<std::shared_mutex> lock(m_mtx);
+    auto disk_plots = GroupPassedPlotsByDisk(challenge, bits_of_filter);
+    if (disk_plots.empty()) {
+        return {};
+    }
+    auto disk_results = RunOnDisks(disk_plots, [this, &challenge](std::vector<std::size_t> const& plot_indexes) {
+        std::vector<chiapos::QualityStringPack> res;
+        for (std::size_t i : plot_indexes) {
+            std::vector<chiapos::QualityStringPack> qstrs;
+            if (m_plots.GetPlotFile(i).GetQualityString(challenge, qstrs)) {
+                std::move(std::begin(qstrs), std::end(qstrs), std::back_inserter(res));
+            }
+        }
+        return res;
+    });
     std::vector<chiapos::QualityStringPack> res;
-    for (auto const& plotFile : m_plotter_files) {
-        if (bits_of_filter > 0 && !chiapos::PassesFilter(plotFile.GetPlotId(), challenge, bits_of_filter)) {
-            continue;
+    for (auto& qstrs : disk_results) {
+        std::move(std::begin(qstrs), std::end(qstrs), std::back_inserter(res));
+    }
+    return res;
+}
+
+std::vector<QualityCandidate> Prover::QueryBestQualities(uint256 const& challenge, int bits_of_filter,
+                                                         uint64_t difficulty, int difficulty_constant_factor_bits,
+                                                         int base_iters, int max_candidates,
+                                                         chiapos::ProvingTicket const& ticket,
+                                                         int* out_num_qualities) const {
+    assert(max_candidates > 0);
+    if (out_num_qualities) {
+        *out_num_qualities = 0;
+    }
+    std::shared_lock<std::shared_mutex> lock(m_mtx);
+    auto disk_plots = GroupPassedPlotsByDisk(challenge, bits_of_filter);
+    if (disk_plots.empty()) {
+        return {};
+    }
+    using DiskResult = std::pair<std::vector<QualityCandidate>, int>;
+    auto disk_results = RunOnDisks(disk_plots, [&](std::vector<std::size_t> const& plot_indexes) -> DiskResult {
+        DiskResult res;
+        res.first.reserve(max_candidates);
+        res.second = 0;
+        auto evaluate = [&](std::size_t i, int index, uint256 const& mixed_quality_string) {
+            uint8_t k = m_plots.GetK(i);
+            double quality_in_plot;
+            arith_uint256 quality;
+            uint64_t iters = chiapos::CalculateIterationsQuality(mixed_quality_string, difficulty, bits_of_filter,
+                                                                 difficulty_constant_factor_bits, k, base_iters,
+                                                                 &quality_in_plot, &quality);
+            PLOGD << tinyformat::format("checking pos, quality_in_plot=%1.3f, quality=%e, iters=%lld, k=%d",
+                                        quality_in_plot, quality.getdouble(), chiapos::MakeNumberStr(iters), (int)k);
+            PushCandidate(res.first, max_candidates,
+                          QualityCandidate{static_cast<uint32_t>(i), index, iters, mixed_quality_string});
+            ++res.second;
+        };
+        // The compressed plots are decompressed on the proving scheduler while the others are read from the disk
+        std::vector<std::pair<std::size_t, std::future<chiapos::optional<std::vector<uint256>>>>> decompressing;
+        for (std::size_t i : plot_indexes) {
+            if (ticket.IsCancelled()) {
+                // The challenge is changed, the rest plots are skipped
+                break;
+            }
+            auto const& plot_file = m_plots.GetPlotFile(i);
+            if (plot_file.GetCompressionLevel() > 0) {
+                decompressing.emplace_back(i, plot_file.AsyncGetMixedQualityStrings(challenge, ticket));
+                continue;
+            }
+            plot_file.VisitMixedQualityStrings(challenge, [&](int index, uint256 const& mixed_quality_string) {
+                evaluate(i, index, mixed_quality_string);
+            });
+        }
+        for (auto& entry : decompressing) {
+            auto mixed_quality_strings = entry.second.get();
+            if (!mixed_quality_strings.has_value()) {
+                PLOGD << tinyformat::format("qualities are dropped, plot: %s",
+                                            m_plots.GetPlotFile(entry.first).GetPath());
+                continue;
+            }
+            for (std::size_t index = 0; index < mixed_quality_strings->size(); ++index) {
+                evaluate(entry.first, static_cast<int>(index), (*mixed_quality_strings)[index]);
+            }
+        }
+        return res;
+    });
+    std::vector<QualityCandidate> res;
+    for (auto const& disk_result : disk_results) {
+        for (auto const& candidate : disk_result.first) {
+            PushCandidate(res, max_candidates, candidate);
         }
-        PLOG_DEBUG << "passed for plot-id: " << plotFile.GetPlotId().GetHex() << ", challenge: " << challenge.GetHex();
-        std::vector<chiapos::QualityStringPack> qstrs;
-        if (plotFile.GetQualityString(challenge, qstrs)) {
-            std::copy(std::begin(qstrs), std::end(qstrs), std::back_inserter(res));
+        if (out_num_qualities) {
+            *out_num_qualities += disk_result.second;
         }
     }
+    std::sort_heap(std::begin(res), std::end(res), CompareCandidates);
+    for (auto& candidate : res) {
+        candidate.plot_file = m_plots.GetPlotFile(candidate.plot_index);
+    }
     return res;
 }
 
 void Prover::RevokeByFarmerPk(chiapos::PubKey const& farmer_pk) {
-    auto it_rm = std::remove_if(std::begin(m_plotter_files), std::end(m_plotter_files),
-                                [&farmer_pk](chiapos::CPlotFile const& plot_file) -> bool {
-                                    chiapos::PlotMemo memo;
-                                    plot_file.ReadMemo(memo);
-                                    assert(memo.farmer_pk.size() == farmer_pk.size());
-                                    return (chiapos::MakeArray<chiapos::PK_LEN>(memo.farmer_pk) == farmer_pk);
-                                });
-    m_plotter_files.erase(it_rm, std::end(m_plotter_files));
+    std::unique_lock<std::shared_mutex> lock(m_mtx);
+    std::size_t n = m_plots.RevokeFarmer(farmer_pk);
+    if (n == 0) {
+        return;
+    }
+    PLOGI << tinyformat::format("%d plots are revoked", n);
 }
 
 bool Prover::QueryFullProof(Path const& plot_path, uint256 const& challenge, int index, chiapos::Bytes& out,
-                            chiapos::PubKey& out_farmer_pk) {
-    chiapos::CPlotFile plotFile(plot_path.string());
+                            chiapos::PubKey& out_farmer_pk) const {
+    chiapos::CPlotFile plotFile = FindPlotFile(plot_path);
     chiapos::PlotMemo memo;
     if (!plotFile.ReadMemo(memo)) {
         throw std::runtime_error(tinyformat::format("cannot read memo from plot file: %s", plot_path));
@@ -184,9 +525,20 @@ bool Prover::QueryFullProof(Path const& plot_path, uint256 const& challenge, int
     return plotFile.GetFullProof(challenge, index, out);
 }
 
-bool Prover::ReadPlotMemo(Path const& plot_file_path, chiapos::PlotMemo& out) {
-    chiapos::CPlotFile plotFile(plot_file_path.string());
-    return plotFile.ReadMemo(out);
+bool Prover::ReadPlotMemo(Path const& plot_file_path, chiapos::PlotMemo& out) const {
+    return FindPlotFile(plot_file_path).ReadMemo(out);
+}
+
+chiapos::CPlotFile Prover::FindPlotFile(Path const& plot_path) const {
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mtx);
+        std::size_t plot_index = m_plots.Find(plot_path.string());
+        if (plot_index != PlotRegistry::npos) {
+            return m_plots.GetPlotFile(plot_index);
+        }
+    }
+    PLOGD << tinyformat::format("plot isn't loaded by prover, open it: %s", plot_path);
+    return chiapos::CPlotFile(plot_path.string());
 }
 
 chiapos::Bytes Prover::CalculateLocalPkBytes(chiapos::Bytes const& local_master_sk) {
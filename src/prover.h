@@ -2,10 +2,14 @@
 #define BHD_MINER_PROVER_H
 
 #include <chiapos_types.h>
+#include <plot_registry.h>
 #include <pos.h>
 #include <uint256.h>
 
+#include <cstdint>
 #include <memory>
+#include <shared_mutex>
+#include <string>
 #include <vector>
 
 #include <bhd_types.h>
@@ -14,26 +18,103 @@ namespace miner {
 
 std::vector<Path> StrListToPathList(std::vector<std::string> const& str_list);
 
+DiskId GetDiskId(std::string const& file_path);
+
+/// A compact record of a quality found from a plot
+struct QualityCandidate {
+    uint32_t plot_index;  // the index of the plot in the prover while querying, it might be changed after that
+    int index;            // the index of the proof in the plot
+    uint64_t iters;
+    uint256 mixed_quality_string;
+    chiapos::CPlotFile plot_file;  // the plot, it is only set on the returned candidates
+};
+
+/// The plots changed by `Prover::UpdatePlots`
+struct PlotChanges {
+    std::vector<std::string> added;    // the plots are added or reloaded
+    std::vector<std::string> removed;  // the plots are found and removed
+};
+
 class Prover {
-    std::vector<chiapos::CPlotFile> m_plotter_files;
+    mutable std::shared_mutex m_mtx;  // the plots are added or removed by the watcher while querying
+    std::vector<uint8_t> m_allowed_k_vec;
+    PlotRegistry m_plots;
 
 public:
-    Prover(std::vector<Path> const& path_list, std::vector<uint8_t> const& allowed_k_vec);
-
+    /**
+     * @brief Load the plots from the dirs, the plots on different disks are loaded at the same time
+     *
+     * @param cache_path The file to save the plot headers, the plots are not opened until they are queried when
+     * they are found from the cache, an empty path to disable the cache
+     */
+    Prover(std::vector<Path> const& path_list, std::vector<uint8_t> const& allowed_k_vec,
+           std::string const& cache_path = "");
+
+    /**
+     * @brief The netspace which is sent to the timelords with the group hash
+     *
+     * It is the total file size of the plot files found at startup, the bad plots are not counted but the plots with
+     * a disallowed k are. Both values are calculated once when the plots are loaded, they aren't changed by the plots
+     * added, removed or revoked later, the timelords always receive the same values from the miner.
+     */
     uint64_t GetTotalSize() const { return m_total_size; }
 
+    /// The hash of the plot-ids of the plots loaded at startup in order, see `GetTotalSize()`
     uint256 GetGroupHash() const { return m_group_hash; }
 
-    int GetNumOfPlots() const { return m_plotter_files.size(); }
+    /// The number of the plots can be used for mining, the revoked plots are excluded
+    int GetNumOfPlots() const;
+
+    int GetNumOfDisks() const;
+
+    /// The statistics of the plots grouped by the farmer public-keys
+    std::vector<FarmerGroup> GetFarmerGroups() const;
+
+    std::vector<std::string> GetPlotPaths() const;
+
+    /**
+     * @brief Add a plot to the prover, the plot is reloaded when it is already added
+     *
+     * @return false when the plot cannot be opened or its k isn't allowed, the plot with the same path is removed
+     */
+    bool AddPlot(std::string const& file_path);
+
+    /// Remove a plot from the prover, returns false when it isn't found
+    bool RemovePlot(std::string const& file_path);
+
+    /**
+     * @brief Add and remove the plots in one batch, the lock is taken and the summary is updated only once
+     *
+     * The plots to add are opened before locking, a plot is reloaded when it is already added. The plots which
+     * cannot be opened or whose k isn't allowed are not in the returned `added`, the plots with the same paths are
+     * removed.
+     */
+    PlotChanges UpdatePlots(std::vector<std::string> const& add_paths, std::vector<std::string> const& remove_paths);
 
     std::vector<chiapos::QualityStringPack> GetQualityStrings(uint256 const& challenge, int bits_of_filter) const;
 
+    /**
+     * @brief Find the qualities with the least iters, each quality is evaluated as soon as it is read from the plot
+     * and only the best `max_candidates` are kept
+     *
+     * @param ticket The qualities of the compressed plots are read on the proving scheduler with the ticket, the
+     * plots whose jobs are dropped are skipped, no more plot is read after the ticket is cancelled
+     * @param out_num_qualities How many qualities are found in total
+     *
+     * @return The best candidates, sorted by iters
+     */
+    std::vector<QualityCandidate> QueryBestQualities(uint256 const& challenge, int bits_of_filter, uint64_t difficulty,
+                                                     int difficulty_constant_factor_bits, int base_iters,
+                                                     int max_candidates, chiapos::ProvingTicket const& ticket,
+                                                     int* out_num_qualities = nullptr) const;
+
+    /// Stop using the plots of the farmer, it only marks the farmer group and the memos aren't read again
     void RevokeByFarmerPk(chiapos::PubKey const& farmer_pk);
 
-    static bool QueryFullProof(Path const& plot_path, uint256 const& challenge, int index, chiapos::Bytes& out,
-                               chiapos::PubKey& out_farmer_pk);
+    bool QueryFullProof(Path const& plot_path, uint256 const& challenge, int index, chiapos::Bytes& out,
+                        chiapos::PubKey& out_farmer_pk) const;
 
-    static bool ReadPlotMemo(Path const& plot_file_path, chiapos::PlotMemo& out);
+    bool ReadPlotMemo(Path const& plot_file_path, chiapos::PlotMemo& out) const;
 
     static chiapos::Bytes CalculateLocalPkBytes(chiapos::Bytes const& local_master_sk);
 
@@ -41,6 +122,18 @@ public:
                             chiapos::Bytes const& proof);
 
 private:
+    /// Get the opened plot from the handle table, the plot will be opened if it isn't loaded by the prover
+    chiapos::CPlotFile FindPlotFile(Path const& plot_path) const;
+
+    /// Find the plots pass the filter, the indexes are grouped by the disks, `m_mtx` must be held
+    std::vector<std::vector<std::size_t>> GroupPassedPlotsByDisk(uint256 const& challenge, int bits_of_filter) const;
+
+    /// Open the plot and check the k, returns an empty plot when it cannot be used, `out_bad` is set when the plot
+    /// cannot be opened
+    chiapos::CPlotFile OpenPlot(std::string const& file_path, bool* out_bad = nullptr) const;
+
+    bool IsAllowedK(uint8_t k) const;
+
     uint64_t m_total_size{0};
     uint256 m_group_hash;
 };
@@ -0,0 +1,27 @@
+#include "reconnect_backoff.h"
+
+#include <algorithm>
+
+namespace miner {
+
+ReconnectBackoff::ReconnectBackoff() : ReconnectBackoff(std::chrono::seconds(3), std::chrono::minutes(2)) {}
+
+ReconnectBackoff::ReconnectBackoff(Duration min_delay, Duration max_delay)
+        : m_min_delay(std::max(min_delay, Duration(1))),
+          m_max_delay(std::max(max_delay, m_min_delay)),
+          m_rng(std::random_device()()) {}
+
+ReconnectBackoff::Duration ReconnectBackoff::Next() {
+    Duration delay = m_min_delay;
+    for (int i = 0; i < m_num_failures && delay < m_max_delay; ++i) {
+        delay *= 2;
+    }
+    delay = std::min(delay, m_max_delay);
+    ++m_num_failures;
+    std::uniform_int_distribution<Duration::rep> jitter(0, delay.count() / 2);
+    return delay + Duration(jitter(m_rng));
+}
+
+void ReconnectBackoff::Reset() { m_num_failures = 0; }
+
+}  // namespace miner
@@ -0,0 +1,41 @@
+#ifndef DEPINC_MINER_RECONNECT_BACKOFF_H
+#define DEPINC_MINER_RECONNECT_BACKOFF_H
+
+#include <chrono>
+#include <random>
+
+namespace miner {
+
+/**
+ * @brief The delays between the reconnections to an endpoint
+ *
+ * The delay doubles after each failure until it reaches the max delay, a random jitter up to the half of the delay is
+ * added so the clients which lose their connections at the same time don't reconnect at the same time.
+ */
+class ReconnectBackoff {
+public:
+    using Duration = std::chrono::milliseconds;
+
+    /// From 3 seconds to 2 minutes
+    ReconnectBackoff();
+
+    ReconnectBackoff(Duration min_delay, Duration max_delay);
+
+    /// The delay before the next reconnection, it counts as a failure
+    Duration Next();
+
+    /// The connection is stable, the next delay starts from the min delay again
+    void Reset();
+
+    int GetNumOfFailures() const { return m_num_failures; }
+
+private:
+    Duration m_min_delay;
+    Duration m_max_delay;
+    int m_num_failures{0};
+    std::mt19937 m_rng;
+};
+
+}  // namespace miner
+
+#endif
@@ -4,6 +4,7 @@
 #include <utils.h>
 
 #include <fstream>
+#include <iterator>
 
 #include <bhd_types.h>
 
@@ -47,7 +48,11 @@ RPCClient::RPCClient(bool no_proxy, std::string url, std::string const& cookie_p
 RPCClient::RPCClient(bool no_proxy, std::string url, std::string user, std::string passwd)
         : m_no_proxy(no_proxy), m_url(std::move(url)), m_user(std::move(user)), m_passwd(std::move(passwd)) {}
 
-void RPCClient::SetWallet(std::string const& wallet_name) { m_wallet_name = wallet_name; }
+void RPCClient::SetWallet(std::string const& wallet_name) {
+    std::lock_guard<std::mutex> lg(m_mtx_clients);
+    m_wallet_name = wallet_name;
+    ResetClients();
+}
 
 void RPCClient::LoadCookie() {
     fs::path cookie_path(m_cookie_path_str);
@@ -65,8 +70,10 @@ void RPCClient::LoadCookie() {
     auto pos = auth_str.find_first_of(':');
     std::string user_str = auth_str.substr(0, pos);
     std::string passwd_str = auth_str.substr(pos + 1);
+    std::lock_guard<std::mutex> lg(m_mtx_clients);
     m_user = std::move(user_str);
     m_passwd = std::move(passwd_str);
+    ResetClients();
 }
 
 std::string const& RPCClient::GetCookiePath() const { return m_cookie_path_str; }
@@ -95,7 +102,7 @@ RPCClient::Challenge RPCClient::QueryChallenge() {
             for (auto const& vdf_proof : vdf_proofs.getValues()) {
                 VdfProof local_vdf_proof;
                 local_vdf_proof.challenge = uint256S(vdf_proof["challenge"].get_str());
-                local_vdf_proof.y = chiapos::MakeVDFForm(chiapos::BytesFromHex(vdf_proof["y"].get_str()));
+                local_vdf_proof.y = chiapos::MakeArrayFromHex<chiapos::VDF_FORM_SIZE>(vdf_proof["y"].get_str());
                 local_vdf_proof.proof = chiapos::BytesFromHex(vdf_proof["proof"].get_str());
                 local_vdf_proof.witness_type = vdf_proof["witness_type"].get_int();
                 local_vdf_proof.iters = vdf_proof["iters"].get_int64();
@@ -212,7 +219,7 @@ void RPCClient::BuildRPCJson(UniValue& params, PosProof const& proof) {
     val.pushKV("k", proof.k);
     val.pushKV("pool_pk_or_hash", chiapos::BytesToHex(chiapos::ToBytes(proof.pool_pk_or_hash)));
     val.pushKV("plot_type", static_cast<int>(chiapos::GetType(proof.pool_pk_or_hash)));
-    val.pushKV("local_pk", chiapos::BytesToHex(chiapos::MakeBytes(proof.local_pk)));
+    val.pushKV("local_pk", chiapos::BytesToHex(proof.local_pk));
     val.pushKV("proof", chiapos::BytesToHex(proof.proof));
     params.push_back(val);
 }
@@ -220,7 +227,7 @@ void RPCClient::BuildRPCJson(UniValue& params, PosProof const& proof) {
 void RPCClient::BuildRPCJson(UniValue& params, VdfProof const& proof) {
     UniValue val(UniValue::VOBJ);
     val.pushKV("challenge", proof.challenge.GetHex());
-    val.pushKV("y", chiapos::BytesToHex(chiapos::MakeBytes(proof.y)));
+    val.pushKV("y", chiapos::BytesToHex(proof.y));
     val.pushKV("proof", chiapos::BytesToHex(proof.proof));
     val.pushKV("iters", proof.iters);
     val.pushKV("witness_type", proof.witness_type);
@@ -230,4 +237,36 @@ void RPCClient::BuildRPCJson(UniValue& params, VdfProof const& proof) {
 
 void RPCClient::BuildRPCJsonWithParams(UniValue& out_params) {}
 
+std::unique_ptr<HTTPClient> RPCClient::AcquireClient(bool no_proxy, uint64_t& out_generation) {
+    std::lock_guard<std::mutex> lg(m_mtx_clients);
+    out_generation = m_clients_generation;
+    for (auto it = m_idle_clients.rbegin(); it != m_idle_clients.rend(); ++it) {
+        if ((*it)->IsNoProxy() == no_proxy) {
+            auto pclient = std::move(*it);
+            m_idle_clients.erase(std::next(it).base());
+            return pclient;
+        }
+    }
+    std::string url_with_wallet;
+    if (m_wallet_name.empty()) {
+        url_with_wallet = m_url;
+    } else {
+        url_with_wallet = m_url + "/wallet/" + m_wallet_name;
+    }
+    return std::make_unique<HTTPClient>(url_with_wallet, m_user, m_passwd, no_proxy);
+}
+
+void RPCClient::ReleaseClient(std::unique_ptr<HTTPClient> pclient, uint64_t generation) {
+    std::size_t const MAX_IDLE_CLIENTS = 4;
+    std::lock_guard<std::mutex> lg(m_mtx_clients);
+    if (generation == m_clients_generation && m_idle_clients.size() < MAX_IDLE_CLIENTS) {
+        m_idle_clients.push_back(std::move(pclient));
+    }
+}
+
+void RPCClient::ResetClients() {
+    m_idle_clients.clear();
+    ++m_clients_generation;
+}
+
 }  // namespace miner
@@ -14,7 +14,10 @@
 #include <uint256.h>
 
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "http_client.h"
 
@@ -190,7 +193,7 @@ private:
 
     template <size_t N>
     void BuildRPCJson(UniValue& params, std::array<uint8_t, N> const& val) {
-        BuildRPCJson(params, chiapos::BytesToHex(chiapos::MakeBytes(val)));
+        BuildRPCJson(params, chiapos::BytesToHex(val));
     }
 
     template <typename T>
@@ -209,6 +212,15 @@ private:
 
     void BuildRPCJsonWithParams(UniValue& out_params);
 
+    /// Take an idle connection from the pool or make a new one
+    std::unique_ptr<HTTPClient> AcquireClient(bool no_proxy, uint64_t& out_generation);
+
+    /// Put the connection back to the pool, it is closed when the pool has been reset since it was acquired
+    void ReleaseClient(std::unique_ptr<HTTPClient> pclient, uint64_t generation);
+
+    /// Close all idle connections, they are made again with the new wallet or credentials, `m_mtx_clients` is held
+    void ResetClients();
+
     template <typename V, typename... T>
     void BuildRPCJsonWithParams(UniValue& outParams, V&& val, T&&... vals) {
         BuildRPCJson(outParams, std::forward<V>(val));
@@ -224,32 +236,29 @@ private:
         BuildRPCJsonWithParams(params, std::forward<T>(vals)...);
         root.pushKV("params", params);
         // Invoke curl
-        std::string url_with_wallet;
-        if (m_wallet_name.empty()) {
-            url_with_wallet = m_url;
-        } else {
-            url_with_wallet = m_url + "/wallet/" + m_wallet_name;
-        }
-        HTTPClient client(url_with_wallet, m_user, m_passwd, no_proxy);
+        uint64_t generation;
+        auto pclient = AcquireClient(no_proxy, generation);
         std::string send_str = root.write();
         PLOG_DEBUG << "sending: `" << send_str << "`";
         bool succ;
         int code;
         std::string err_str;
-        std::tie(succ, code, err_str) = client.Send(send_str);
+        std::tie(succ, code, err_str) = pclient->Send(send_str);
         if (!succ) {
+            // the connection is dropped with the client
             std::stringstream ss;
             ss << "RPC command error `" << method_name << "`: " << err_str;
             throw NetError(ss.str().c_str());
         }
         // Analyze the result
-        chiapos::Bytes received_data = client.GetReceivedData();
+        chiapos::Bytes const& received_data = pclient->GetReceivedData();
         if (received_data.empty()) {
             throw NetError("empty result from RPC server");
         }
         char const* psz = reinterpret_cast<char const*>(received_data.data());
         UniValue res;
         res.read(psz, received_data.size());
+        ReleaseClient(std::move(pclient), generation);
 
         // Build result and return
         PLOG_DEBUG << "received: `" << res.write() << "`";
@@ -276,6 +285,10 @@ private:
     std::string m_url;
     std::string m_user;
     std::string m_passwd;
+    // the challenge monitor sends requests from its own thread while the cookie might be reloaded
+    std::mutex m_mtx_clients;
+    std::vector<std::unique_ptr<HTTPClient>> m_idle_clients;
+    uint64_t m_clients_generation{0};
 };
 
 }  // namespace miner
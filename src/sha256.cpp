@@ -1,39 +1,311 @@
 #include "sha256.h"
 
-CSHA256::CSHA256()
-    : m_ctx(EVP_MD_CTX_create())
-{
-    EVP_DigestInit(m_ctx, EVP_sha256());
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SHA256_USE_SHANI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace sha256 {
+
+namespace {
+
+uint32_t const K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+uint32_t const INITIAL_STATE[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+inline uint32_t Rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+inline uint32_t Sigma0(uint32_t x) { return Rotr(x, 2) ^ Rotr(x, 13) ^ Rotr(x, 22); }
+
+inline uint32_t Sigma1(uint32_t x) { return Rotr(x, 6) ^ Rotr(x, 11) ^ Rotr(x, 25); }
+
+inline uint32_t sigma0(uint32_t x) { return Rotr(x, 7) ^ Rotr(x, 18) ^ (x >> 3); }
+
+inline uint32_t sigma1(uint32_t x) { return Rotr(x, 17) ^ Rotr(x, 19) ^ (x >> 10); }
+
+inline uint32_t Ch(uint32_t x, uint32_t y, uint32_t z) { return z ^ (x & (y ^ z)); }
+
+inline uint32_t Maj(uint32_t x, uint32_t y, uint32_t z) { return (x & y) | (z & (x | y)); }
+
+inline uint32_t ReadBE32(uint8_t const* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+/// The schedule of the padding block for a 64-byte message, it is the same for every message
+struct PaddingSchedule {
+    uint32_t w[64];
+
+    PaddingSchedule() {
+        w[0] = 0x80000000;
+        for (int t = 1; t < 15; ++t) {
+            w[t] = 0;
+        }
+        w[15] = 64 * 8;
+        for (int t = 16; t < 64; ++t) {
+            w[t] = sigma1(w[t - 2]) + w[t - 7] + sigma0(w[t - 15]) + w[t - 16];
+        }
+        for (int t = 0; t < 64; ++t) {
+            w[t] += K[t];
+        }
+    }
+};
+
+PaddingSchedule const PADDING_SCHEDULE;
+
+/// Run 64 rounds on MULTI_WAYS states, `wk` holds W[t] + K[t] for each round and each lane
+inline void RoundsMulti(uint32_t (&s)[8][MULTI_WAYS], uint32_t const (&wk)[64][MULTI_WAYS]) {
+    for (int t = 0; t < 64; ++t) {
+        for (int l = 0; l < MULTI_WAYS; ++l) {
+            uint32_t t1 = s[7][l] + Sigma1(s[4][l]) + Ch(s[4][l], s[5][l], s[6][l]) + wk[t][l];
+            uint32_t t2 = Sigma0(s[0][l]) + Maj(s[0][l], s[1][l], s[2][l]);
+            s[7][l] = s[6][l];
+            s[6][l] = s[5][l];
+            s[5][l] = s[4][l];
+            s[4][l] = s[3][l] + t1;
+            s[3][l] = s[2][l];
+            s[2][l] = s[1][l];
+            s[1][l] = s[0][l];
+            s[0][l] = t1 + t2;
+        }
+    }
+}
+
+inline void WriteBE32(uint8_t* p, uint32_t x) {
+    p[0] = static_cast<uint8_t>(x >> 24);
+    p[1] = static_cast<uint8_t>(x >> 16);
+    p[2] = static_cast<uint8_t>(x >> 8);
+    p[3] = static_cast<uint8_t>(x);
+}
+
+inline void WriteBE64(uint8_t* p, uint64_t x) {
+    WriteBE32(p, static_cast<uint32_t>(x >> 32));
+    WriteBE32(p + 4, static_cast<uint32_t>(x));
+}
+
+using TransformFunc = void (*)(uint32_t* s, uint8_t const* chunk, std::size_t blocks);
+
+void TransformGeneric(uint32_t* s, uint8_t const* chunk, std::size_t blocks) {
+    while (blocks--) {
+        uint32_t w[64];
+        for (int t = 0; t < 16; ++t) {
+            w[t] = ReadBE32(chunk + t * 4);
+        }
+        for (int t = 16; t < 64; ++t) {
+            w[t] = sigma1(w[t - 2]) + w[t - 7] + sigma0(w[t - 15]) + w[t - 16];
+        }
+        uint32_t a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+        for (int t = 0; t < 64; ++t) {
+            uint32_t t1 = h + Sigma1(e) + Ch(e, f, g) + K[t] + w[t];
+            uint32_t t2 = Sigma0(a) + Maj(a, b, c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        s[0] += a;
+        s[1] += b;
+        s[2] += c;
+        s[3] += d;
+        s[4] += e;
+        s[5] += f;
+        s[6] += g;
+        s[7] += h;
+        chunk += 64;
+    }
+}
+
+#ifdef SHA256_USE_SHANI
+
+__attribute__((target("sha,sse4.1"))) void TransformShaNI(uint32_t* s, uint8_t const* chunk, std::size_t blocks) {
+    __m128i const BSWAP_MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    // The instructions work on the state in the order of ABEF and CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&s[0])), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&s[4])), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+    while (blocks--) {
+        __m128i abef_save = state0;
+        __m128i cdgh_save = state1;
+        __m128i msgs[4];
+        for (int i = 0; i < 4; ++i) {
+            msgs[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(chunk + i * 16)), BSWAP_MASK);
+        }
+        for (int q = 0; q < 16; ++q) {
+            if (q >= 4) {
+                // W[q] = sigma1(W[t-2]) + W[t-7] + sigma0(W[t-15]) + W[t-16] for the 4 words of this quad
+                __m128i w = _mm_sha256msg1_epu32(msgs[q % 4], msgs[(q + 1) % 4]);
+                w = _mm_add_epi32(w, _mm_alignr_epi8(msgs[(q + 3) % 4], msgs[(q + 2) % 4], 4));
+                msgs[q % 4] = _mm_sha256msg2_epu32(w, msgs[(q + 3) % 4]);
+            }
+            __m128i wk = _mm_add_epi32(msgs[q % 4], _mm_loadu_si128(reinterpret_cast<__m128i const*>(&K[q * 4])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0E));
+        }
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+        chunk += 64;
+    }
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&s[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&s[4]), state1);
 }
 
-CSHA256::~CSHA256()
-{
-    if (m_ctx != nullptr) {
-        EVP_MD_CTX_free(m_ctx);
+bool HasShaNI() {
+    uint32_t eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & bit_SSE4_1) == 0) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
     }
+    return (ebx & bit_SHA) != 0;
 }
 
-CSHA256::CSHA256(CSHA256&& rhs)
-    : m_ctx(rhs.m_ctx)
-{
-    rhs.m_ctx = nullptr;
+#endif
+
+struct Implementation {
+    TransformFunc transform;
+    char const* name;
+};
+
+Implementation SelectImplementation() {
+#ifdef SHA256_USE_SHANI
+    if (HasShaNI()) {
+        return {&TransformShaNI, "shani"};
+    }
+#endif
+    return {&TransformGeneric, "generic"};
 }
 
-CSHA256& CSHA256::operator=(CSHA256&& rhs)
-{
-    if (&rhs != this) {
-        m_ctx = rhs.m_ctx;
-        rhs.m_ctx = nullptr;
+Implementation const& GetSelected() {
+    static Implementation const selected = SelectImplementation();
+    return selected;
+}
+
+}  // namespace
+
+Hasher::Hasher() { Reset(); }
+
+Hasher& Hasher::Reset() {
+    memcpy(m_state, INITIAL_STATE, sizeof(m_state));
+    m_bytes = 0;
+    return *this;
+}
+
+Hasher& Hasher::Write(void const* p, std::size_t size) {
+    auto data = static_cast<uint8_t const*>(p);
+    std::size_t used = m_bytes % 64;
+    m_bytes += size;
+    if (used > 0) {
+        std::size_t n = std::min<std::size_t>(64 - used, size);
+        memcpy(m_buf + used, data, n);
+        data += n;
+        size -= n;
+        if (used + n < 64) {
+            return *this;
+        }
+        GetSelected().transform(m_state, m_buf, 1);
+    }
+    if (size >= 64) {
+        std::size_t blocks = size / 64;
+        GetSelected().transform(m_state, data, blocks);
+        data += blocks * 64;
+        size -= blocks * 64;
     }
+    memcpy(m_buf, data, size);
     return *this;
 }
 
-void CSHA256::Write(void const* p, uint64_t size)
-{
-    EVP_DigestUpdate(m_ctx, p, size);
+void Hasher::Finalize(uint8_t* pout) {
+    static uint8_t const PADDING[64] = {0x80};
+    uint8_t size_desc[8];
+    WriteBE64(size_desc, m_bytes << 3);
+    Write(PADDING, 1 + ((119 - (m_bytes % 64)) % 64));
+    Write(size_desc, sizeof(size_desc));
+    for (int i = 0; i < 8; ++i) {
+        WriteBE32(pout + i * 4, m_state[i]);
+    }
+}
+
+Digest Hasher::Finalize() {
+    Digest res;
+    Finalize(res.data());
+    return res;
 }
 
-void CSHA256::Finalize(uint8_t* pout)
-{
-    EVP_DigestFinal(m_ctx, pout, nullptr);
+Digest Hash(void const* p, std::size_t size) { return Hasher().Write(p, size).Finalize(); }
+
+char const* GetImplementation() { return GetSelected().name; }
+
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__)
+// The lanes are independent, so the loops above are vectorized, build an AVX2 version which is selected at runtime
+__attribute__((target_clones("avx2", "default")))
+#endif
+void HashPairsFirstWord(uint32_t out[MULTI_WAYS], uint8_t const* const prefixes[MULTI_WAYS], uint8_t const* suffix) {
+    uint32_t w[64][MULTI_WAYS];
+    for (int t = 0; t < 8; ++t) {
+        for (int l = 0; l < MULTI_WAYS; ++l) {
+            w[t][l] = ReadBE32(prefixes[l] + t * 4);
+            w[t + 8][l] = ReadBE32(suffix + t * 4);
+        }
+    }
+    for (int t = 16; t < 64; ++t) {
+        for (int l = 0; l < MULTI_WAYS; ++l) {
+            w[t][l] = sigma1(w[t - 2][l]) + w[t - 7][l] + sigma0(w[t - 15][l]) + w[t - 16][l];
+        }
+    }
+    for (int t = 0; t < 64; ++t) {
+        for (int l = 0; l < MULTI_WAYS; ++l) {
+            w[t][l] += K[t];
+        }
+    }
+    // The first block is the message itself
+    uint32_t s[8][MULTI_WAYS];
+    for (int i = 0; i < 8; ++i) {
+        for (int l = 0; l < MULTI_WAYS; ++l) {
+            s[i][l] = INITIAL_STATE[i];
+        }
+    }
+    RoundsMulti(s, w);
+    uint32_t mid[8][MULTI_WAYS];
+    for (int i = 0; i < 8; ++i) {
+        for (int l = 0; l < MULTI_WAYS; ++l) {
+            s[i][l] += INITIAL_STATE[i];
+            mid[i][l] = s[i][l];
+        }
+    }
+    // The second block is the padding, its schedule is shared by all lanes
+    for (int t = 0; t < 64; ++t) {
+        for (int l = 0; l < MULTI_WAYS; ++l) {
+            w[t][l] = PADDING_SCHEDULE.w[t];
+        }
+    }
+    RoundsMulti(s, w);
+    for (int l = 0; l < MULTI_WAYS; ++l) {
+        out[l] = s[0][l] + mid[0][l];
+    }
 }
+
+}  // namespace sha256
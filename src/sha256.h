@@ -1,28 +1,74 @@
 #ifndef DEPINC_MINER_SHA256_H
 #define DEPINC_MINER_SHA256_H
 
-#include <openssl/evp.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 
+namespace sha256 {
+
+int const OUTPUT_SIZE = 256 / 8;
+
+using Digest = std::array<uint8_t, OUTPUT_SIZE>;
+
+/// SHA-256 context without any heap allocation, the transform is selected at runtime (SHA-NI when it is available)
+class Hasher {
+public:
+    Hasher();
+
+    Hasher& Write(void const* p, std::size_t size);
+
+    void Finalize(uint8_t* pout);
+
+    Digest Finalize();
+
+    Hasher& Reset();
+
+private:
+    uint32_t m_state[8];
+    uint8_t m_buf[64];
+    uint64_t m_bytes;
+};
+
+/// Hash a buffer in one call
+Digest Hash(void const* p, std::size_t size);
+
+/// The name of the transform selected for the running CPU
+char const* GetImplementation();
+
+/// How many messages are hashed together by the multi-buffer kernels
+int const MULTI_WAYS = 8;
+
+/**
+ * @brief Hash MULTI_WAYS messages of 64 bytes at once, each message is a 32-byte prefix followed by the shared suffix
+ *
+ * @param out The first 32-bit word (big-endian) of each digest, enough to compare the leading bits of the hash
+ * @param prefixes The first 32 bytes of each message
+ * @param suffix The last 32 bytes of all messages
+ */
+void HashPairsFirstWord(uint32_t out[MULTI_WAYS], uint8_t const* const prefixes[MULTI_WAYS], uint8_t const* suffix);
+
+}  // namespace sha256
+
+/// Compatible wrapper of the original OpenSSL based hasher, it is a sha256::Hasher now
 class CSHA256
 {
-    EVP_MD_CTX* m_ctx;
+    sha256::Hasher m_hasher;
 
 public:
-    static const int OUTPUT_SIZE = 256/8;
+    static const int OUTPUT_SIZE = sha256::OUTPUT_SIZE;
 
-    CSHA256();
+    CSHA256() = default;
 
     CSHA256(CSHA256 const&) = delete;
     CSHA256& operator=(CSHA256 const&) = delete;
 
-    CSHA256(CSHA256&&);
-    CSHA256& operator=(CSHA256&&);
+    CSHA256(CSHA256&&) = default;
+    CSHA256& operator=(CSHA256&&) = default;
 
-    ~CSHA256();
+    void Write(void const* p, uint64_t size) { m_hasher.Write(p, size); }
 
-    void Write(void const* p, uint64_t size);
-
-    void Finalize(uint8_t* pout);
+    void Finalize(uint8_t* pout) { m_hasher.Finalize(pout); }
 };
 
-#endif
\ No newline at end of file
+#endif
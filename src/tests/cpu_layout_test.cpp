@@ -0,0 +1,94 @@
+#include "test.h"
+
+#include <cpu_layout.h>
+
+#include <ostream>
+#include <vector>
+
+namespace {
+
+std::ostream& operator<<(std::ostream& os, std::vector<int> const& cpus) {
+    os << "[";
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+        os << (i > 0 ? "," : "") << cpus[i];
+    }
+    return os << "]";
+}
+
+std::vector<int> Range(int first, int last) {
+    std::vector<int> res;
+    for (int cpu = first; cpu <= last; ++cpu) {
+        res.push_back(cpu);
+    }
+    return res;
+}
+
+}  // namespace
+
+TEST_CASE(CpuLayout_ParseCpuList) {
+    CHECK_EQ(miner::ParseCpuList("0-3"), Range(0, 3));
+    CHECK_EQ(miner::ParseCpuList("0-1,4,6-7\n"), (std::vector<int>{0, 1, 4, 6, 7}));
+    CHECK_EQ(miner::ParseCpuList("5"), std::vector<int>{5});
+    CHECK(miner::ParseCpuList("").empty());
+    CHECK(miner::ParseCpuList("\n").empty());
+    CHECK(miner::ParseCpuList("3-1").empty());
+    CHECK(miner::ParseCpuList("a-b").empty());
+}
+
+TEST_CASE(CpuLayout_NodeAlignedRangeSize) {
+    CHECK_EQ(miner::GetNodeAlignedRangeSize({Range(0, 7)}), 8);
+    CHECK_EQ(miner::GetNodeAlignedRangeSize({Range(0, 31), Range(32, 63)}), 32);
+    CHECK_EQ(miner::GetNodeAlignedRangeSize({miner::ParseCpuList("0-15,32-47"), miner::ParseCpuList("16-31,48-63")}),
+             16);
+    CHECK_EQ(miner::GetNodeAlignedRangeSize({{0, 2, 4, 6}, {1, 3, 5, 7}}), 1);
+    // a gap in the numbering
+    CHECK_EQ(miner::GetNodeAlignedRangeSize({{0, 1}, {3, 4}}), 0);
+    CHECK_EQ(miner::GetNodeAlignedRangeSize({}), 0);
+}
+
+TEST_CASE(CpuLayout_OneNode) {
+    auto layout = miner::MakeCpuLayout({Range(0, 7)}, 0, 0, 1, true);
+    CHECK_EQ(layout.num_contexts, 1);
+    CHECK_EQ(layout.threads_per_context, 7);
+    CHECK(layout.cpu_affinity);
+    CHECK_EQ(layout.reserved_cpus, std::vector<int>{7});
+}
+
+TEST_CASE(CpuLayout_ContiguousNodes) {
+    // The default layout is pinned even with the reserved core, each context takes one node
+    auto layout = miner::MakeCpuLayout({Range(0, 31), Range(32, 63)}, 0, 0, 1, true);
+    CHECK_EQ(layout.num_contexts, 2);
+    CHECK_EQ(layout.threads_per_context, 32);
+    CHECK(layout.cpu_affinity);
+    CHECK_EQ(layout.reserved_cpus, std::vector<int>{63});
+}
+
+TEST_CASE(CpuLayout_InterleavedNodes) {
+    auto nodes = std::vector<std::vector<int>>{miner::ParseCpuList("0-15,32-47"), miner::ParseCpuList("16-31,48-63")};
+    auto layout = miner::MakeCpuLayout(nodes, 0, 0, 2, true);
+    CHECK_EQ(layout.num_contexts, 4);
+    CHECK_EQ(layout.threads_per_context, 16);
+    CHECK(layout.cpu_affinity);
+    CHECK_EQ(layout.reserved_cpus, (std::vector<int>{62, 63}));
+}
+
+TEST_CASE(CpuLayout_FinelyInterleavedNodes) {
+    // The ranges would be a single CPU, the threads are not pinned
+    auto layout = miner::MakeCpuLayout({{0, 2, 4, 6}, {1, 3, 5, 7}}, 0, 0, 1, true);
+    CHECK_EQ(layout.num_contexts, 2);
+    CHECK_EQ(layout.threads_per_context, 3);
+    CHECK(!layout.cpu_affinity);
+}
+
+TEST_CASE(CpuLayout_ExplicitSettings) {
+    auto nodes = std::vector<std::vector<int>>{Range(0, 7), Range(8, 15)};
+    auto inside = miner::MakeCpuLayout(nodes, 4, 4, 0, true);
+    CHECK_EQ(inside.num_contexts, 4);
+    CHECK_EQ(inside.threads_per_context, 4);
+    CHECK(inside.cpu_affinity);
+    // context 1 takes the CPUs 6-11 which cross the nodes
+    auto crossing = miner::MakeCpuLayout(nodes, 2, 6, 0, true);
+    CHECK(!crossing.cpu_affinity);
+    auto unpinned = miner::MakeCpuLayout(nodes, 0, 0, 1, false);
+    CHECK(!unpinned.cpu_affinity);
+}
@@ -0,0 +1,248 @@
+#include "test.h"
+
+#include <timelord_client.h>
+#include <utils.h>
+
+#include <univalue.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "msg_ids.h"
+
+namespace {
+
+std::size_t const VDF_FORM_SIZE = 100;
+
+void WriteVarInt(Bytes& out, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        out.push_back(byte | (value != 0 ? 0x80 : 0));
+    } while (value != 0);
+}
+
+/// Encode the payload of a FRAME_PROOF frame the way the front-end does, the frame type isn't included
+Bytes EncodeProofPayload(uint16_t msg_id, uint256 const& challenge, ProofDetail const& detail) {
+    Bytes res;
+    res.push_back(static_cast<uint8_t>(msg_id >> 8));
+    res.push_back(static_cast<uint8_t>(msg_id));
+    res.insert(std::end(res), challenge.begin(), challenge.end());
+    res.insert(std::end(res), std::begin(detail.y), std::end(detail.y));
+    res.push_back(detail.witness_type);
+    WriteVarInt(res, detail.iters);
+    WriteVarInt(res, detail.duration);
+    WriteVarInt(res, detail.proof.size());
+    res.insert(std::end(res), std::begin(detail.proof), std::end(detail.proof));
+    return res;
+}
+
+/// Make a whole frame with the header
+std::string MakeFrame(uint8_t type, Bytes const& payload) {
+    uint32_t size = payload.size() + 1;
+    std::string res;
+    res.push_back(static_cast<char>(size >> 24));
+    res.push_back(static_cast<char>(size >> 16));
+    res.push_back(static_cast<char>(size >> 8));
+    res.push_back(static_cast<char>(size));
+    res.push_back(static_cast<char>(type));
+    res.append(std::begin(payload), std::end(payload));
+    return res;
+}
+
+ProofDetail MakeProof(uint64_t iters) {
+    ProofDetail detail;
+    detail.y = Bytes(VDF_FORM_SIZE, 0xab);
+    detail.proof = Bytes(300, 0xcd);
+    detail.witness_type = 2;
+    detail.iters = iters;
+    detail.duration = 42;
+    return detail;
+}
+
+uint256 MakeChallenge() {
+    uint256 challenge;
+    for (int i = 0; i < static_cast<int>(uint256::WIDTH); ++i) {
+        challenge.begin()[i] = static_cast<uint8_t>(i);
+    }
+    return challenge;
+}
+
+bool Decode(Bytes const& payload, ProofFrame& out) { return DecodeProofFrame(payload.data(), payload.size(), out); }
+
+std::string MakeJsonMessage(UniValue const& msg) { return msg.write() + '\0'; }
+
+/// Read a NUL-terminated JSON message from the socket
+UniValue ReadJsonMessage(tcp::socket& s, asio::streambuf& buf) {
+    std::size_t n = asio::read_until(s, buf, '\0');
+    std::string str(static_cast<char const*>(buf.data().data()), n - 1);
+    buf.consume(n);
+    UniValue msg;
+    msg.read(str);
+    return msg;
+}
+
+}  // namespace
+
+TEST_CASE(Frame_DecodeProof) {
+    auto challenge = MakeChallenge();
+    for (uint64_t iters : {uint64_t(0), uint64_t(127), uint64_t(128), uint64_t(1) << 40, ~uint64_t(0)}) {
+        auto detail = MakeProof(iters);
+        ProofFrame frame;
+        CHECK(Decode(EncodeProofPayload(static_cast<uint16_t>(TimelordMsgs::PROOF), challenge, detail), frame));
+        CHECK_EQ(frame.msg_id, static_cast<uint16_t>(TimelordMsgs::PROOF));
+        CHECK(frame.challenge == challenge);
+        CHECK(frame.detail.y == detail.y);
+        CHECK(frame.detail.proof == detail.proof);
+        CHECK_EQ((int)frame.detail.witness_type, 2);
+        CHECK_EQ(frame.detail.iters, iters);
+        CHECK_EQ(frame.detail.duration, 42);
+    }
+    ProofFrame frame;
+    CHECK(Decode(EncodeProofPayload(static_cast<uint16_t>(TimelordMsgs::CALC_REPLY), challenge, MakeProof(1)), frame));
+}
+
+TEST_CASE(Frame_RejectInvalidProof) {
+    auto payload = EncodeProofPayload(static_cast<uint16_t>(TimelordMsgs::PROOF), MakeChallenge(), MakeProof(1000));
+    ProofFrame frame;
+    // truncated at every position
+    for (std::size_t size = 0; size < payload.size(); ++size) {
+        if (DecodeProofFrame(payload.data(), size, frame)) {
+            CHECK_EQ(size, payload.size());
+        }
+    }
+    // extra bytes after the proof
+    auto extra = payload;
+    extra.push_back(0);
+    CHECK(!Decode(extra, frame));
+    // only PROOF and CALC_REPLY carry proofs
+    CHECK(!Decode(EncodeProofPayload(static_cast<uint16_t>(TimelordMsgs::PONG), MakeChallenge(), MakeProof(1)),
+                  frame));
+}
+
+TEST_CASE(Frame_RejectOverflowedVarInt) {
+    // The payload before the iters, then the iters of 10 bytes with 2 in the last one which needs 65 bits
+    auto payload = EncodeProofPayload(static_cast<uint16_t>(TimelordMsgs::PROOF), MakeChallenge(), MakeProof(0));
+    payload.resize(2 + uint256::WIDTH + VDF_FORM_SIZE + 1);
+    for (int i = 0; i < 9; ++i) {
+        payload.push_back(0xff);
+    }
+    payload.push_back(0x02);
+    WriteVarInt(payload, 0);
+    WriteVarInt(payload, 0);
+    ProofFrame frame;
+    CHECK(!Decode(payload, frame));
+    // The largest value fits in 10 bytes
+    payload.resize(2 + uint256::WIDTH + VDF_FORM_SIZE + 1);
+    WriteVarInt(payload, ~uint64_t(0));
+    CHECK_EQ(payload.size(), 2 + uint256::WIDTH + VDF_FORM_SIZE + 1 + 10);
+    WriteVarInt(payload, 0);
+    WriteVarInt(payload, 0);
+    CHECK(Decode(payload, frame));
+    CHECK_EQ(frame.detail.iters, ~uint64_t(0));
+}
+
+namespace {
+
+/**
+ * @brief Run a front-end on the loopback and connect a timelord client to it
+ *
+ * @param framings The framings listed in the PONG, empty to send a PONG without `framings`
+ *
+ * @return The proof received by the client and all data the front-end read from the client
+ */
+std::pair<std::vector<ProofDetail>, std::string> RunFrontEnd(std::vector<std::string> const& framings) {
+    asio::io_context server_ioc;
+    tcp::acceptor acceptor(server_ioc, tcp::endpoint(asio::ip::make_address("127.0.0.1"), 0));
+    unsigned short port = acceptor.local_endpoint().port();
+    std::string received;
+    std::thread server([&]() {
+        tcp::socket s(server_ioc);
+        acceptor.accept(s);
+        asio::streambuf buf;
+        auto ping = ReadJsonMessage(s, buf);
+        CHECK_EQ(ping["id"].get_int(), static_cast<int>(TimelordClientMsgs::PING));
+        UniValue pong(UniValue::VOBJ);
+        pong.pushKV("id", static_cast<int>(TimelordMsgs::PONG));
+        if (!framings.empty()) {
+            UniValue names(UniValue::VARR);
+            for (auto const& name : framings) {
+                names.push_back(name);
+            }
+            pong.pushKV("framings", names);
+        }
+        asio::write(s, asio::buffer(MakeJsonMessage(pong)));
+        auto detail = MakeProof(1000);
+        std::string data;
+        if (!framings.empty()) {
+            auto framing = ReadJsonMessage(s, buf);
+            CHECK_EQ(framing["id"].get_int(), static_cast<int>(TimelordClientMsgs::FRAMING));
+            // The reply and the first frame are read by the client together
+            UniValue reply(UniValue::VOBJ);
+            reply.pushKV("id", static_cast<int>(TimelordMsgs::FRAMING_REPLY));
+            reply.pushKV("framing", framing["framing"].get_str());
+            data = MakeJsonMessage(reply) +
+                   MakeFrame(FrontEndClient::FRAME_PROOF,
+                             EncodeProofPayload(static_cast<uint16_t>(TimelordMsgs::PROOF), MakeChallenge(), detail));
+        } else {
+            UniValue proof(UniValue::VOBJ);
+            proof.pushKV("id", static_cast<int>(TimelordMsgs::PROOF));
+            proof.pushKV("challenge", MakeChallenge().GetHex());
+            proof.pushKV("y", chiapos::BytesToHex(detail.y));
+            proof.pushKV("proof", chiapos::BytesToHex(detail.proof));
+            proof.pushKV("witness_type", detail.witness_type);
+            proof.pushKV("iters", detail.iters);
+            proof.pushKV("duration", detail.duration);
+            data = MakeJsonMessage(proof);
+        }
+        asio::write(s, asio::buffer(data));
+        // Keep what the client sends until it closes the connection
+        asio::error_code ec;
+        asio::read(s, buf, ec);
+        received.assign(static_cast<char const*>(buf.data().data()), buf.size());
+    });
+
+    asio::io_context ioc;
+    std::vector<ProofDetail> proofs;
+    auto client = TimelordClient::CreateTimelordClient(ioc);
+    client->SetConnectionHandler([]() {});
+    client->SetErrorHandler([](FrontEndClient::ErrorType, std::string const&) {});
+    client->SetProofReceiver([&](uint256 const& challenge, ProofDetail const& detail) {
+        CHECK(challenge == MakeChallenge());
+        proofs.push_back(detail);
+        client->Exit();
+    });
+    asio::steady_timer timeout(ioc);
+    timeout.expires_after(std::chrono::seconds(10));
+    timeout.async_wait([&](asio::error_code const& ec) {
+        if (!ec) {
+            client->Exit();
+        }
+    });
+    client->Connect("127.0.0.1", port);
+    ioc.run_for(std::chrono::seconds(10));
+    timeout.cancel();
+    server.join();
+    return std::make_pair(proofs, received);
+}
+
+}  // namespace
+
+TEST_CASE(Frame_SwitchToBinaryAfterAdvertised) {
+    auto res = RunFrontEnd({"binary-v2", "binary-v1"});
+    CHECK_EQ(res.first.size(), 1u);
+    if (!res.first.empty()) {
+        CHECK_EQ(res.first.front().iters, 1000u);
+        CHECK(res.first.front().proof == MakeProof(1000).proof);
+    }
+}
+
+TEST_CASE(Frame_NoFramingRequestUnlessAdvertised) {
+    auto res = RunFrontEnd({});
+    CHECK_EQ(res.first.size(), 1u);
+    // The FRAMING id must never be sent to a front-end which doesn't list the framing
+    CHECK(res.second.find(std::to_string(static_cast<int>(TimelordClientMsgs::FRAMING))) == std::string::npos);
+}
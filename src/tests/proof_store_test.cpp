@@ -0,0 +1,97 @@
+#include "test.h"
+
+#include <proof_store.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+ProofDetail MakeProof(uint64_t iters) {
+    ProofDetail detail;
+    detail.y = chiapos::Bytes(100, static_cast<uint8_t>(iters));
+    detail.proof = chiapos::Bytes(8, static_cast<uint8_t>(iters));
+    detail.witness_type = 0;
+    detail.iters = iters;
+    detail.duration = 1;
+    return detail;
+}
+
+uint256 MakeChallenge(int n) {
+    uint256 challenge;
+    *challenge.begin() = static_cast<uint8_t>(n);
+    return challenge;
+}
+
+}  // namespace
+
+TEST_CASE(ProofStore_QueryTheLeastIters) {
+    miner::ProofStore store(3);
+    auto challenge = MakeChallenge(1);
+    CHECK(!store.Query(challenge, 0).has_value());
+    CHECK(store.Save(challenge, MakeProof(300)));
+    CHECK(store.Save(challenge, MakeProof(100)));
+    CHECK(store.Save(challenge, MakeProof(200)));
+    CHECK_EQ(store.Query(challenge, 0)->iters, 100u);
+    CHECK_EQ(store.Query(challenge, 100)->iters, 100u);
+    CHECK_EQ(store.Query(challenge, 101)->iters, 200u);
+    CHECK_EQ(store.Query(challenge, 300)->iters, 300u);
+    CHECK(!store.Query(challenge, 301).has_value());
+    CHECK(!store.Query(MakeChallenge(2), 0).has_value());
+}
+
+TEST_CASE(ProofStore_DuplicatedIters) {
+    miner::ProofStore store(3);
+    auto challenge = MakeChallenge(1);
+    CHECK(store.Save(challenge, MakeProof(100)));
+    CHECK(!store.Save(challenge, MakeProof(100)));
+    CHECK_EQ(store.GetNumOfChallenges(), 1u);
+}
+
+TEST_CASE(ProofStore_EvictTheOldestChallenge) {
+    miner::ProofStore store(2);
+    store.Save(MakeChallenge(1), MakeProof(100));
+    store.Save(MakeChallenge(2), MakeProof(100));
+    // a new proof of a saved challenge doesn't make it newer
+    store.Save(MakeChallenge(1), MakeProof(200));
+    store.Save(MakeChallenge(3), MakeProof(100));
+    CHECK_EQ(store.GetNumOfChallenges(), 2u);
+    CHECK(!store.Query(MakeChallenge(1), 0).has_value());
+    CHECK(store.Query(MakeChallenge(2), 0).has_value());
+    CHECK(store.Query(MakeChallenge(3), 0).has_value());
+}
+
+TEST_CASE(ProofStore_ReadWhileWriting) {
+    miner::ProofStore store(1);
+    auto challenge = MakeChallenge(1);
+    int const NUM_PROOFS = 2000;
+    std::atomic_bool done{false};
+    std::atomic_int num_bad_reads{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            uint64_t last_iters{0};
+            while (!done) {
+                // The proofs are saved with decreasing iters, a reader never sees the least iters going up
+                auto proof = store.Query(challenge, 0);
+                if (!proof.has_value()) {
+                    continue;
+                }
+                if ((last_iters != 0 && proof->iters > last_iters) || proof->y.size() != 100) {
+                    ++num_bad_reads;
+                }
+                last_iters = proof->iters;
+            }
+        });
+    }
+    for (int i = NUM_PROOFS; i > 0; --i) {
+        store.Save(challenge, MakeProof(i));
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    CHECK_EQ(num_bad_reads.load(), 0);
+    CHECK_EQ(store.Query(challenge, 0)->iters, 1u);
+}
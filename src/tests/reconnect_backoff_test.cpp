@@ -0,0 +1,77 @@
+#include "test.h"
+
+#include <reconnect_backoff.h>
+#include <timelord_client.h>
+
+#include <chrono>
+
+using std::chrono::milliseconds;
+
+TEST_CASE(ReconnectBackoff_DoublesWithJitter) {
+    miner::ReconnectBackoff backoff(milliseconds(100), milliseconds(1000));
+    // 100, 200, 400, 800 then it stays at the max, the jitter is up to the half of the delay
+    long long const EXPECTED_DELAYS[] = {100, 200, 400, 800, 1000, 1000, 1000};
+    for (long long expected : EXPECTED_DELAYS) {
+        auto delay = backoff.Next().count();
+        CHECK(delay >= expected);
+        CHECK(delay <= expected + expected / 2);
+    }
+    CHECK_EQ(backoff.GetNumOfFailures(), 7);
+}
+
+TEST_CASE(ReconnectBackoff_Reset) {
+    miner::ReconnectBackoff backoff(milliseconds(100), milliseconds(1000));
+    for (int i = 0; i < 5; ++i) {
+        backoff.Next();
+    }
+    backoff.Reset();
+    CHECK_EQ(backoff.GetNumOfFailures(), 0);
+    auto delay = backoff.Next().count();
+    CHECK(delay >= 100 && delay <= 150);
+}
+
+TEST_CASE(ReconnectBackoff_InvalidRange) {
+    // The max delay is raised to the min delay, a zero min delay is raised to 1ms
+    miner::ReconnectBackoff backoff(milliseconds(500), milliseconds(100));
+    auto delay = backoff.Next().count();
+    CHECK(delay >= 500 && delay <= 750);
+    miner::ReconnectBackoff zero(milliseconds(0), milliseconds(0));
+    CHECK(zero.Next().count() >= 1);
+}
+
+TEST_CASE(ReconnectBackoff_DefaultRange) {
+    miner::ReconnectBackoff backoff;
+    auto first = backoff.Next();
+    CHECK(first >= std::chrono::seconds(3) && first <= milliseconds(4500));
+    // 6s, 12s, 24s, 48s, 96s, then it stays at 2 minutes without overflowing after many failures
+    for (int i = 1; i < 100; ++i) {
+        auto delay = backoff.Next();
+        CHECK(delay <= std::chrono::minutes(3));
+        if (i >= 6) {
+            CHECK(delay >= std::chrono::minutes(2));
+        }
+    }
+}
+
+TEST_CASE(TimelordStats_HealthScore) {
+    TimelordStats stats;
+    CHECK(!stats.HasSamples());
+    CHECK_EQ(stats.GetHealthScore(), 1.0);
+    stats.AddRoundTrip(milliseconds(1000));
+    CHECK(stats.HasSamples());
+    // One second of round-trip time halves the score
+    CHECK_EQ(stats.GetHealthScore(), 0.5);
+    // The proof arrival time doesn't change the score
+    stats.AddProofArrival(milliseconds(60000));
+    CHECK_EQ(stats.GetHealthScore(), 0.5);
+    double before = stats.GetHealthScore();
+    stats.AddFailure();
+    CHECK(stats.GetHealthScore() < before);
+    for (int i = 0; i < 100; ++i) {
+        stats.AddFailure();
+    }
+    CHECK(stats.GetHealthScore() > 0);
+    double failed = stats.GetHealthScore();
+    stats.AddConnected();
+    CHECK(stats.GetHealthScore() > failed);
+}
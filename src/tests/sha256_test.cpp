@@ -0,0 +1,87 @@
+#include "test.h"
+
+#include <sha256.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+
+std::string ToHex(sha256::Digest const& digest) {
+    std::string res;
+    char buf[3];
+    for (uint8_t b : digest) {
+        snprintf(buf, sizeof(buf), "%02x", b);
+        res += buf;
+    }
+    return res;
+}
+
+std::string HashHex(std::string const& str) { return ToHex(sha256::Hash(str.data(), str.size())); }
+
+uint32_t ReadBE32(uint8_t const* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+}  // namespace
+
+TEST_CASE(Sha256_KnownVectors) {
+    CHECK_EQ(HashHex(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK_EQ(HashHex("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    CHECK_EQ(HashHex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+             "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    CHECK_EQ(HashHex(std::string(1000000, 'a')), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST_CASE(Sha256_IncrementalWrites) {
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        data.push_back(static_cast<char>(i * 7));
+    }
+    // Every split point crosses the 64-byte blocks differently
+    for (std::size_t split : {0, 1, 55, 56, 63, 64, 65, 127, 128, 500, 1000}) {
+        sha256::Hasher hasher;
+        hasher.Write(data.data(), split).Write(data.data() + split, data.size() - split);
+        CHECK_EQ(ToHex(hasher.Finalize()), HashHex(data));
+    }
+}
+
+TEST_CASE(Sha256_Reset) {
+    sha256::Hasher hasher;
+    hasher.Write("garbage", 7);
+    hasher.Reset().Write("abc", 3);
+    CHECK_EQ(ToHex(hasher.Finalize()), HashHex("abc"));
+}
+
+TEST_CASE(Sha256_CompatibleWrapper) {
+    CSHA256 hasher;
+    hasher.Write(reinterpret_cast<uint8_t const*>("abc"), 3);
+    sha256::Digest digest;
+    hasher.Finalize(digest.data());
+    CHECK_EQ(ToHex(digest), HashHex("abc"));
+}
+
+TEST_CASE(Sha256_HashPairsFirstWord) {
+    uint8_t prefixes_data[sha256::MULTI_WAYS][32];
+    uint8_t const* prefixes[sha256::MULTI_WAYS];
+    for (int l = 0; l < sha256::MULTI_WAYS; ++l) {
+        for (int i = 0; i < 32; ++i) {
+            prefixes_data[l][i] = static_cast<uint8_t>(l * 31 + i);
+        }
+        prefixes[l] = prefixes_data[l];
+    }
+    uint8_t suffix[32];
+    for (int i = 0; i < 32; ++i) {
+        suffix[i] = static_cast<uint8_t>(0xff - i);
+    }
+    uint32_t first_words[sha256::MULTI_WAYS];
+    sha256::HashPairsFirstWord(first_words, prefixes, suffix);
+    for (int l = 0; l < sha256::MULTI_WAYS; ++l) {
+        uint8_t message[64];
+        memcpy(message, prefixes[l], 32);
+        memcpy(message + 32, suffix, 32);
+        CHECK_EQ(first_words[l], ReadBE32(sha256::Hash(message, sizeof(message)).data()));
+    }
+}
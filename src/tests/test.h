@@ -0,0 +1,59 @@
+#ifndef DEPINC_MINER_TEST_H
+#define DEPINC_MINER_TEST_H
+
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace miner {
+namespace test {
+
+using TestFunc = std::function<void()>;
+
+struct TestCase {
+    std::string name;
+    TestFunc func;
+};
+
+/// All test cases of the test binary, they are registered by `TEST_CASE` before `main` runs
+std::vector<TestCase>& GetTestCases();
+
+/// Record a failed check of the running test case, the test case keeps running
+void Fail(char const* file, int line, std::string const& msg);
+
+struct Registrar {
+    Registrar(char const* name, TestFunc func) { GetTestCases().push_back(TestCase{name, std::move(func)}); }
+};
+
+}  // namespace test
+}  // namespace miner
+
+/// Define a test case, it is registered before `main` starts and run by the test binary
+#define TEST_CASE(name)                                                \
+    static void name();                                                \
+    static miner::test::Registrar const name##_registrar(#name, name); \
+    static void name()
+
+/// Check the condition, the test case is marked as failed and it keeps running when the condition is false
+#define CHECK(cond)                                       \
+    do {                                                  \
+        if (!(cond)) {                                    \
+            miner::test::Fail(__FILE__, __LINE__, #cond); \
+        }                                                 \
+    } while (false)
+
+/// Check the values are equal, both values are printed when they aren't, they are copied first so a member of a
+/// temporary can be checked, they must be printable to a stream
+#define CHECK_EQ(lhs, rhs)                                                                         \
+    do {                                                                                           \
+        auto const check_lhs = (lhs);                                                              \
+        auto const check_rhs = (rhs);                                                              \
+        if (!(check_lhs == check_rhs)) {                                                           \
+            std::stringstream check_ss;                                                            \
+            check_ss << #lhs << " == " << #rhs << " (" << check_lhs << " vs " << check_rhs << ")"; \
+            miner::test::Fail(__FILE__, __LINE__, check_ss.str());                                 \
+        }                                                                                          \
+    } while (false)
+
+#endif
@@ -0,0 +1,50 @@
+#include "test.h"
+
+#include <iostream>
+
+namespace miner {
+namespace test {
+
+namespace {
+
+int g_num_failures{0};
+
+}  // namespace
+
+std::vector<TestCase>& GetTestCases() {
+    static std::vector<TestCase> test_cases;
+    return test_cases;
+}
+
+void Fail(char const* file, int line, std::string const& msg) {
+    ++g_num_failures;
+    std::cerr << file << ":" << line << ": check failed: " << msg << std::endl;
+}
+
+}  // namespace test
+}  // namespace miner
+
+int main(int argc, char** argv) {
+    // Run only the test cases whose names contain the first argument when it is given
+    std::string filter = argc > 1 ? argv[1] : "";
+    int num_failed_cases{0}, num_run{0};
+    for (auto const& test_case : miner::test::GetTestCases()) {
+        if (!filter.empty() && test_case.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        ++num_run;
+        int num_failures = miner::test::g_num_failures;
+        try {
+            test_case.func();
+        } catch (std::exception const& e) {
+            miner::test::Fail(__FILE__, __LINE__, std::string("exception: ") + e.what());
+        }
+        bool passed = miner::test::g_num_failures == num_failures;
+        if (!passed) {
+            ++num_failed_cases;
+        }
+        std::cout << (passed ? "[ PASS ] " : "[ FAIL ] ") << test_case.name << std::endl;
+    }
+    std::cout << num_run - num_failed_cases << "/" << num_run << " test case(s) passed" << std::endl;
+    return num_failed_cases == 0 ? 0 : 1;
+}
@@ -7,21 +7,122 @@
 #include <tinyformat.h>
 #include <plog/Log.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "msg_ids.h"
 
 static int const SECONDS_TO_PING = 60;
 static int const WAIT_PONG_TIMEOUT_SECONDS = 10;
+static std::size_t const FRAME_HEADER_SIZE = 4;
+static std::size_t const MAX_FRAME_SIZE = 1024 * 1024;
+static std::size_t const VDF_FORM_SIZE = 100;
+static char const* const BINARY_FRAMING_NAME = "binary-v1";
+static int const CONNECTION_ATTEMPT_DELAY_MILLIS = 250;
+static int const CONNECT_TIMEOUT_SECONDS = 10;
+
+namespace {
+
+uint32_t ReadBE32(uint8_t const* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+/// Reads the fields of a binary frame in place, a read fails when there isn't enough data
+class FrameReader {
+public:
+    FrameReader(uint8_t const* data, std::size_t size) : p_(data), end_(data + size) {}
+
+    /// Returns the pointer to the next `n` bytes and skips them, nullptr when there isn't enough data
+    uint8_t const* Take(std::size_t n) {
+        if (static_cast<std::size_t>(end_ - p_) < n) {
+            return nullptr;
+        }
+        uint8_t const* res = p_;
+        p_ += n;
+        return res;
+    }
+
+    bool ReadU8(uint8_t& out) {
+        auto p = Take(1);
+        if (p == nullptr) {
+            return false;
+        }
+        out = p[0];
+        return true;
+    }
+
+    bool ReadU16(uint16_t& out) {
+        auto p = Take(2);
+        if (p == nullptr) {
+            return false;
+        }
+        out = static_cast<uint16_t>((p[0] << 8) | p[1]);
+        return true;
+    }
+
+    bool ReadVarInt(uint64_t& out) {
+        out = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte;
+            if (!ReadU8(byte)) {
+                return false;
+            }
+            if (shift == 63 && (byte & 0x7f) > 1) {
+                // the 10th byte has only 1 bit left, the value overflows
+                return false;
+            }
+            out |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool AtEnd() const { return p_ == end_; }
+
+private:
+    uint8_t const* p_;
+    uint8_t const* end_;
+};
+
+}  // namespace
+
+bool DecodeProofFrame(uint8_t const* data, std::size_t size, ProofFrame& out) {
+    FrameReader reader(data, size);
+    uint8_t const* challenge_data;
+    uint8_t const* y_data;
+    uint64_t duration, proof_size;
+    if (!reader.ReadU16(out.msg_id) || (challenge_data = reader.Take(uint256::WIDTH)) == nullptr ||
+        (y_data = reader.Take(VDF_FORM_SIZE)) == nullptr || !reader.ReadU8(out.detail.witness_type) ||
+        !reader.ReadVarInt(out.detail.iters) || !reader.ReadVarInt(duration) || !reader.ReadVarInt(proof_size)) {
+        PLOGE << tinyformat::format("read error, the proof frame is truncated, size=%d bytes", size);
+        return false;
+    }
+    uint8_t const* proof_data = reader.Take(proof_size);
+    if (proof_data == nullptr || !reader.AtEnd()) {
+        PLOGE << tinyformat::format("read error, invalid proof size %d, frame size=%d bytes", proof_size, size);
+        return false;
+    }
+    if (out.msg_id != static_cast<uint16_t>(TimelordMsgs::PROOF) &&
+        out.msg_id != static_cast<uint16_t>(TimelordMsgs::CALC_REPLY)) {
+        PLOGE << tinyformat::format("read error, unknown msg id %d in the proof frame", out.msg_id);
+        return false;
+    }
+    memcpy(out.challenge.begin(), challenge_data, uint256::WIDTH);
+    out.detail.y.assign(y_data, y_data + VDF_FORM_SIZE);
+    out.detail.proof.assign(proof_data, proof_data + proof_size);
+    out.detail.duration = static_cast<int>(duration);
+    return true;
+}
 
 std::string PointToHex(void const* p) {
     uint64_t val = reinterpret_cast<uint64_t>(p);
-    std::vector<uint8_t> v(sizeof(val));
-    memcpy(v.data(), &val, sizeof(val));
-    return std::string("0x") + chiapos::BytesToHex(v);
+    return std::string("0x") + chiapos::BytesToHex(reinterpret_cast<uint8_t const*>(&val), sizeof(val));
 }
 
-FrontEndClient::FrontEndClient(asio::io_context& ioc) : ioc_(ioc), s_(ioc) {
+FrontEndClient::FrontEndClient(asio::io_context& ioc) : ioc_(ioc), resolver_(ioc), s_(ioc) {
     PLOGD << tinyformat::format("%s: %s", __func__, PointToHex(this));
 }
 
@@ -39,50 +140,175 @@ void FrontEndClient::Connect(std::string const& host, unsigned short port, Conne
     conn_handler_ = std::move(conn_handler);
     msg_handler_ = std::move(msg_handler);
     err_handler_ = std::move(err_handler);
-    // solve the address
-    tcp::resolver r(ioc_);
-    try {
-        tcp::resolver::query q(std::string(host), std::to_string(port));
-        auto it_result = r.resolve(q);
-        if (it_result == std::end(tcp::resolver::results_type())) {
-            // cannot resolve the ip from host name
-            asio::post(ioc_, [self = shared_from_this(), host]() {
-                PLOGE << tinyformat::format("Failed to resolve host=%s", host);
-                self->err_handler_(FrontEndClient::ErrorType::CONN, "cannot resolve host");
+    // solve the address, a slow DNS server must not block the io thread
+    resolver_.async_resolve(
+            host, std::to_string(port),
+            [self = shared_from_this(), host](error_code const& ec, tcp::resolver::results_type results) {
+                if (self->st_ == Status::CLOSED) {
+                    return;
+                }
+                if (ec || results.empty()) {
+                    // cannot resolve the ip from host name
+                    PLOGE << tinyformat::format("Failed to resolve host=%s", host);
+                    self->st_ = Status::CLOSED;
+                    self->err_handler_(FrontEndClient::ErrorType::CONN, "cannot resolve host");
+                    return;
+                }
+                self->DoConnect(results);
             });
+}
+
+struct FrontEndClient::ConnectRace {
+    explicit ConnectRace(asio::io_context& ioc) : timer_next(ioc), timer_timeout(ioc) {}
+
+    std::vector<tcp::endpoint> endpoints;
+    std::size_t next{0};
+    std::vector<std::shared_ptr<tcp::socket>> sockets;
+    int num_running{0};
+    bool done{false};
+    std::string last_errs;
+    asio::steady_timer timer_next;
+    asio::steady_timer timer_timeout;
+};
+
+void FrontEndClient::DoConnect(tcp::resolver::results_type const& results) {
+    race_ = std::make_shared<ConnectRace>(ioc_);
+    // Alternate the address families, starting with the family of the first address (RFC 8305)
+    std::vector<tcp::endpoint> first_family, second_family;
+    bool first_is_v6 = results.begin()->endpoint().address().is_v6();
+    for (auto const& entry : results) {
+        auto& endpoints = entry.endpoint().address().is_v6() == first_is_v6 ? first_family : second_family;
+        endpoints.push_back(entry.endpoint());
+    }
+    for (std::size_t i = 0; i < std::max(first_family.size(), second_family.size()); ++i) {
+        if (i < first_family.size()) {
+            race_->endpoints.push_back(first_family[i]);
+        }
+        if (i < second_family.size()) {
+            race_->endpoints.push_back(second_family[i]);
+        }
+    }
+    race_->timer_timeout.expires_after(std::chrono::seconds(CONNECT_TIMEOUT_SECONDS));
+    race_->timer_timeout.async_wait([self = shared_from_this(), race = race_](error_code const& ec) {
+        if (ec || race->done) {
+            return;
+        }
+        self->FinishConnect(race, nullptr, "connect timeout");
+    });
+    DoStartNextAttempt(race_);
+}
+
+void FrontEndClient::DoStartNextAttempt(std::shared_ptr<ConnectRace> race) {
+    if (race->done || race->next >= race->endpoints.size()) {
+        return;
+    }
+    auto endpoint = race->endpoints[race->next++];
+    auto psocket = std::make_shared<tcp::socket>(ioc_);
+    race->sockets.push_back(psocket);
+    ++race->num_running;
+    psocket->async_connect(endpoint, [self = shared_from_this(), race, psocket, endpoint](error_code const& ec) {
+        --race->num_running;
+        if (race->done) {
+            return;
+        }
+        if (!ec) {
+            self->FinishConnect(race, psocket, "");
             return;
         }
-        // retrieve the first result and start the connection
-        s_.async_connect(*it_result, [self = shared_from_this()](error_code const& ec) {
+        PLOGD << tinyformat::format("failed to connect %s:%d, %s", endpoint.address().to_string(), endpoint.port(),
+                                    ec.message());
+        race->last_errs = ec.message();
+        if (race->next < race->endpoints.size()) {
+            // no need to wait for the delay
+            self->DoStartNextAttempt(race);
+        } else if (race->num_running == 0) {
+            self->FinishConnect(race, nullptr, race->last_errs);
+        }
+    });
+    if (race->next < race->endpoints.size()) {
+        // the next address is tried if this one doesn't connect in time, the previous wait is cancelled
+        race->timer_next.expires_after(std::chrono::milliseconds(CONNECTION_ATTEMPT_DELAY_MILLIS));
+        race->timer_next.async_wait([self = shared_from_this(), race](error_code const& ec) {
             if (ec) {
-                PLOGE << tinyformat::format("Error on connect: %s", ec.message());
-                self->st_ = Status::CLOSED;
-                self->err_handler_(FrontEndClient::ErrorType::CONN, ec.message());
                 return;
             }
-            self->st_ = Status::CONNECTED;
-            self->DoReadNext();
-            self->conn_handler_();
+            self->DoStartNextAttempt(race);
         });
-    } catch (std::exception const& e) {
-        PLOGE << tinyformat::format("error on connecting, %s", e.what());
     }
 }
 
+void FrontEndClient::FinishConnect(std::shared_ptr<ConnectRace> race, std::shared_ptr<tcp::socket> psocket,
+                                   std::string const& errs) {
+    race->done = true;
+    error_code ignored_ec;
+    race->timer_next.cancel(ignored_ec);
+    race->timer_timeout.cancel(ignored_ec);
+    for (auto const& pother : race->sockets) {
+        if (pother != psocket) {
+            pother->close(ignored_ec);
+        }
+    }
+    race_.reset();
+    if (psocket == nullptr) {
+        PLOGE << tinyformat::format("Error on connect: %s", errs);
+        st_ = Status::CLOSED;
+        err_handler_(FrontEndClient::ErrorType::CONN, errs);
+        return;
+    }
+    s_ = std::move(*psocket);
+    st_ = Status::CONNECTED;
+    DoReadNext();
+    conn_handler_();
+}
+
+void FrontEndClient::StopConnect() {
+    resolver_.cancel();
+    if (race_ == nullptr) {
+        return;
+    }
+    race_->done = true;
+    error_code ignored_ec;
+    race_->timer_next.cancel(ignored_ec);
+    race_->timer_timeout.cancel(ignored_ec);
+    for (auto const& psocket : race_->sockets) {
+        psocket->close(ignored_ec);
+    }
+    race_.reset();
+}
+
 bool FrontEndClient::SendMessage(UniValue const& msg) {
     if (st_ != Status::CONNECTED) {
         return false;
     }
-    asio::post(ioc_, [self = shared_from_this(), msg]() {
-        bool do_send = self->sending_msgs_.empty();
-        self->sending_msgs_.push_back(msg.write());
-        if (do_send) {
+    return SendSerialized(Serialize(msg));
+}
+
+std::shared_ptr<std::string const> FrontEndClient::Serialize(UniValue const& msg) {
+    auto data = std::make_shared<std::string>(msg.write());
+    data->push_back('\0');
+    return data;
+}
+
+bool FrontEndClient::SendSerialized(std::shared_ptr<std::string const> data) {
+    if (st_ != Status::CONNECTED) {
+        return false;
+    }
+    asio::post(ioc_, [self = shared_from_this(), data = std::move(data)]() mutable {
+        self->sending_msgs_.push_back(std::move(data));
+        if (self->writing_msgs_.empty()) {
             self->DoSendNext();
         }
     });
     return true;
 }
 
+void FrontEndClient::SetProofHandler(ProofHandler proof_handler) { proof_handler_ = std::move(proof_handler); }
+
+void FrontEndClient::SwitchToBinaryFraming() {
+    PLOGI << "timelord messages are switched to binary framing";
+    binary_framing_ = true;
+}
+
 void FrontEndClient::Exit() {
     PLOGD << tinyformat::format("%s: FrontEndClient(%s)", __func__, PointToHex(this));
 
@@ -91,12 +317,17 @@ void FrontEndClient::Exit() {
     }
     st_ = Status::CLOSED;
 
+    StopConnect();
     error_code ignored_ec;
     s_.shutdown(tcp::socket::shutdown_both, ignored_ec);
     s_.close(ignored_ec);
 }
 
 void FrontEndClient::DoReadNext() {
+    if (binary_framing_) {
+        DoReadNextFrame();
+        return;
+    }
     asio::async_read_until(s_, read_buf_, '\0', [self = shared_from_this()](error_code const& ec, std::size_t bytes) {
         if (ec) {
             if (ec != asio::error::operation_aborted && ec != asio::error::eof) {
@@ -105,37 +336,156 @@ void FrontEndClient::DoReadNext() {
             self->err_handler_(FrontEndClient::ErrorType::READ, ec.message());
             return;
         }
-        std::string result = static_cast<char const*>(self->read_buf_.data().data());
-        self->read_buf_.consume(bytes);
         try {
+            // Parse the message from the read buffer directly, the NUL terminator is excluded
             UniValue msg;
-            msg.read(result);
+            msg.read(static_cast<char const*>(self->read_buf_.data().data()), bytes - 1);
+            self->read_buf_.consume(bytes);
             self->msg_handler_(msg);
         } catch (std::exception const& e) {
             PLOGE << tinyformat::format("read error, %s, total read=%d bytes", e.what(), bytes);
             self->err_handler_(FrontEndClient::ErrorType::READ, ec.message());
+            return;
         }
         self->DoReadNext();
     });
 }
 
+void FrontEndClient::DoReadNextFrame() {
+    // Handle the frames which are already read, the data after the message that switches the framing is kept in the
+    // buffer
+    while (read_buf_.size() >= FRAME_HEADER_SIZE) {
+        auto data = static_cast<uint8_t const*>(read_buf_.data().data());
+        std::size_t size = ReadBE32(data);
+        if (size == 0 || size > MAX_FRAME_SIZE) {
+            PLOGE << tinyformat::format("read error, invalid frame size %d", size);
+            err_handler_(FrontEndClient::ErrorType::READ, "invalid frame size");
+            return;
+        }
+        if (read_buf_.size() < FRAME_HEADER_SIZE + size) {
+            break;
+        }
+        bool succ{false};
+        try {
+            succ = HandleFrame(data + FRAME_HEADER_SIZE, size);
+        } catch (std::exception const& e) {
+            PLOGE << tinyformat::format("read error, %s, frame size=%d bytes", e.what(), size);
+        }
+        read_buf_.consume(FRAME_HEADER_SIZE + size);
+        if (!succ) {
+            err_handler_(FrontEndClient::ErrorType::READ, "invalid frame");
+            return;
+        }
+    }
+    std::size_t required = FRAME_HEADER_SIZE;
+    if (read_buf_.size() >= FRAME_HEADER_SIZE) {
+        required += ReadBE32(static_cast<uint8_t const*>(read_buf_.data().data()));
+    }
+    asio::async_read(s_, read_buf_, asio::transfer_exactly(required - read_buf_.size()),
+                     [self = shared_from_this()](error_code const& ec, std::size_t) {
+                         if (ec) {
+                             if (ec != asio::error::operation_aborted && ec != asio::error::eof) {
+                                 PLOGE << tinyformat::format("read error, %s", ec.message());
+                             }
+                             self->err_handler_(FrontEndClient::ErrorType::READ, ec.message());
+                             return;
+                         }
+                         self->DoReadNextFrame();
+                     });
+}
+
+bool FrontEndClient::HandleFrame(uint8_t const* data, std::size_t size) {
+    FrameReader reader(data, size);
+    uint8_t type{0};
+    reader.ReadU8(type);
+    if (type == FRAME_JSON) {
+        try {
+            UniValue msg;
+            if (!msg.read(reinterpret_cast<char const*>(data + 1), size - 1)) {
+                PLOGE << tinyformat::format("read error, invalid json frame, size=%d bytes", size);
+                return false;
+            }
+            msg_handler_(msg);
+        } catch (std::exception const& e) {
+            PLOGE << tinyformat::format("read error, %s, size=%d bytes", e.what(), size);
+        }
+        return true;
+    }
+    if (type != FRAME_PROOF) {
+        // unknown frames are skipped, the front-end might be newer
+        PLOGD << tinyformat::format("skip frame type=%d, size=%d bytes", (int)type, size);
+        return true;
+    }
+    ProofFrame frame;
+    if (!DecodeProofFrame(data + 1, size - 1, frame)) {
+        return false;
+    }
+    PLOGD << tinyformat::format("(timelord): msgid=%s, binary frame",
+                                TimelordMsgIdToString(static_cast<TimelordMsgs>(frame.msg_id)));
+    if (proof_handler_) {
+        proof_handler_(frame.challenge, frame.detail);
+    }
+    return true;
+}
+
 void FrontEndClient::DoSendNext() {
-    assert(!sending_msgs_.empty());
-    auto const& msg = sending_msgs_.front();
-    send_buf_.resize(msg.size() + 1);
-    memcpy(send_buf_.data(), msg.data(), msg.size());
-    send_buf_[msg.size()] = '\0';
-    asio::async_write(s_, asio::buffer(send_buf_),
-                      [self = shared_from_this()](error_code const& ec, std::size_t bytes) {
-                          if (ec) {
-                              self->err_handler_(FrontEndClient::ErrorType::WRITE, ec.message());
-                              return;
-                          }
-                          self->sending_msgs_.pop_front();
-                          if (!self->sending_msgs_.empty()) {
-                              self->DoSendNext();
-                          }
-                      });
+    assert(writing_msgs_.empty() && !sending_msgs_.empty());
+    // All the queued messages go out with one write, they are kept alive until the write is done
+    write_bufs_.clear();
+    while (!sending_msgs_.empty()) {
+        write_bufs_.push_back(asio::buffer(*sending_msgs_.front()));
+        writing_msgs_.push_back(std::move(sending_msgs_.front()));
+        sending_msgs_.pop_front();
+    }
+    asio::async_write(s_, write_bufs_, [self = shared_from_this()](error_code const& ec, std::size_t bytes) {
+        if (ec) {
+            self->err_handler_(FrontEndClient::ErrorType::WRITE, ec.message());
+            return;
+        }
+        self->writing_msgs_.clear();
+        if (!self->sending_msgs_.empty()) {
+            self->DoSendNext();
+        }
+    });
+}
+
+namespace {
+
+/// Smooth the samples like the SRTT of TCP, the first sample is taken as it is
+TimelordStats::Duration Smooth(TimelordStats::Duration avg, TimelordStats::Duration sample, int num_samples) {
+    if (num_samples == 1) {
+        return sample;
+    }
+    return avg + (sample - avg) / 8;
+}
+
+}  // namespace
+
+void TimelordStats::AddRoundTrip(Duration rtt) {
+    ++num_rtts_;
+    avg_rtt_ = Smooth(avg_rtt_, rtt, num_rtts_);
+}
+
+void TimelordStats::AddProofArrival(Duration latency) {
+    ++num_proofs_;
+    avg_proof_arrival_ = Smooth(avg_proof_arrival_, latency, num_proofs_);
+}
+
+void TimelordStats::AddWin() { ++num_wins_; }
+
+void TimelordStats::AddConnected() { failure_rate_ -= failure_rate_ / 4; }
+
+void TimelordStats::AddFailure() { failure_rate_ += (1 - failure_rate_) / 4; }
+
+double TimelordStats::GetHealthScore() const {
+    // One second of round-trip time halves the score
+    double latency_factor = 1000.0 / (1000.0 + static_cast<double>(avg_rtt_.count()));
+    return latency_factor * std::max(1 - failure_rate_, 0.01);
+}
+
+std::string TimelordStats::ToString() const {
+    return tinyformat::format("rtt=%dms, proof arrival=%dms, proofs=%d, wins=%d, health=%.2f", avg_rtt_.count(),
+                              avg_proof_arrival_.count(), num_proofs_, num_wins_, GetHealthScore());
 }
 
 std::shared_ptr<TimelordClient> TimelordClient::CreateTimelordClient(asio::io_context& ioc) {
@@ -149,6 +499,24 @@ std::shared_ptr<TimelordClient> TimelordClient::CreateTimelordClient(asio::io_co
         if (self->ptimer_waitpong_) {
             error_code ignored_ec;
             self->ptimer_waitpong_->cancel(ignored_ec);
+            if (self->pstats_) {
+                self->pstats_->AddRoundTrip(std::chrono::duration_cast<TimelordStats::Duration>(
+                        std::chrono::steady_clock::now() - self->ping_sent_));
+            }
+        }
+        // The binary framing is only asked for when the front-end says it supports it, the older front-ends never
+        // receive the FRAMING message
+        if (self->framing_requested_ || !msg.exists("framings") || !msg["framings"].isArray()) {
+            return;
+        }
+        for (auto const& framing : msg["framings"].getValues()) {
+            if (framing.isStr() && framing.get_str() == BINARY_FRAMING_NAME) {
+                UniValue framing_msg(UniValue::VOBJ);
+                framing_msg.pushKV("id", static_cast<int>(TimelordClientMsgs::FRAMING));
+                framing_msg.pushKV("framing", BINARY_FRAMING_NAME);
+                self->framing_requested_ = self->pclient_->SendMessage(framing_msg);
+                break;
+            }
         }
     }));
     pinstance->msg_handlers_.insert(std::make_pair(static_cast<int>(TimelordMsgs::PROOF), [wp](UniValue const& msg) {
@@ -156,16 +524,14 @@ std::shared_ptr<TimelordClient> TimelordClient::CreateTimelordClient(asio::io_co
         if (!self) {
             return;
         }
-        if (self->proof_receiver_) {
-            auto challenge = uint256S(msg["challenge"].get_str());
-            ProofDetail detail;
-            detail.y = chiapos::BytesFromHex(msg["y"].get_str());
-            detail.proof = chiapos::BytesFromHex(msg["proof"].get_str());
-            detail.witness_type = msg["witness_type"].get_int();
-            detail.iters = msg["iters"].get_int64();
-            detail.duration = msg["duration"].get_int();
-            self->proof_receiver_(challenge, detail);
-        }
+        auto challenge = uint256S(msg["challenge"].get_str());
+        ProofDetail detail;
+        detail.y = chiapos::BytesFromHex(msg["y"].get_str());
+        detail.proof = chiapos::BytesFromHex(msg["proof"].get_str());
+        detail.witness_type = msg["witness_type"].get_int();
+        detail.iters = msg["iters"].get_int64();
+        detail.duration = msg["duration"].get_int();
+        self->HandleProof(challenge, detail);
     }));
     pinstance->msg_handlers_.insert(
             std::make_pair(static_cast<int>(TimelordMsgs::CALC_REPLY), [wp](UniValue const& msg) {
@@ -183,13 +549,23 @@ std::shared_ptr<TimelordClient> TimelordClient::CreateTimelordClient(asio::io_co
                     detail.witness_type = msg["witness_type"].get_int();
                     detail.iters = msg["iters"].get_int64();
                     detail.duration = msg["duration"].get_int();
-                    if (self->proof_receiver_) {
-                        self->proof_receiver_(challenge, detail);
-                    }
+                    self->HandleProof(challenge, detail);
                 } else if (!calculating) {
                     PLOGE << tinyformat::format("delay challenge=%s", challenge.GetHex());
                 }
             }));
+    pinstance->msg_handlers_.insert(
+            std::make_pair(static_cast<int>(TimelordMsgs::FRAMING_REPLY), [wp](UniValue const& msg) {
+                auto self = wp.lock();
+                if (!self) {
+                    return;
+                }
+                // The front-end sends the frames after this message
+                if (msg.exists("framing") && msg["framing"].isStr() &&
+                    msg["framing"].get_str() == BINARY_FRAMING_NAME) {
+                    self->pclient_->SwitchToBinaryFraming();
+                }
+            }));
     return pinstance;
 }
 
@@ -206,8 +582,16 @@ void TimelordClient::SetErrorHandler(ErrorHandler err_handler) { err_handler_ =
 
 void TimelordClient::SetProofReceiver(ProofReceiver proof_receiver) { proof_receiver_ = std::move(proof_receiver); }
 
+void TimelordClient::SetStats(std::shared_ptr<TimelordStats> pstats) { pstats_ = std::move(pstats); }
+
 void TimelordClient::Calc(uint256 const& challenge, uint64_t iters, uint256 const& group_hash, uint64_t total_size,
                           int interval_secs) {
+    if (challenge != calc_challenge_ || iters != calc_iters_) {
+        calc_challenge_ = challenge;
+        calc_iters_ = iters;
+        calc_start_ = std::chrono::steady_clock::now();
+        calc_answered_ = false;
+    }
     UniValue msg(UniValue::VOBJ);
     msg.pushKV("id", static_cast<int>(TimelordClientMsgs::CALC));
     msg.pushKV("challenge", challenge.GetHex());
@@ -216,7 +600,12 @@ void TimelordClient::Calc(uint256 const& challenge, uint64_t iters, uint256 cons
     netspace.pushKV("group_hash", group_hash.GetHex());
     netspace.pushKV("total_size", total_size);
     msg.pushKV("netspace", netspace);
-    pclient_->SendMessage(msg);
+    // The same data is sent again by the timer, no need to serialize it every time
+    DoCalc(FrontEndClient::Serialize(msg), interval_secs);
+}
+
+void TimelordClient::DoCalc(std::shared_ptr<std::string const> msg, int interval_secs) {
+    pclient_->SendSerialized(msg);
     if (interval_secs != 0) {
         if (ptimer_sender_) {
             asio::error_code ignored_ec;
@@ -225,18 +614,35 @@ void TimelordClient::Calc(uint256 const& challenge, uint64_t iters, uint256 cons
         // create a new timer
         ptimer_sender_ = std::make_shared<asio::steady_timer>(ioc_);
         ptimer_sender_->expires_from_now(std::chrono::seconds(interval_secs));
-        ptimer_sender_->async_wait([self = shared_from_this(), challenge, iters, group_hash, total_size,
-                                    interval_secs](asio::error_code const& ec) {
-            if (ec) {
-                return;
-            }
-            self->Calc(challenge, iters, group_hash, total_size, interval_secs);
-        });
+        ptimer_sender_->async_wait(
+                [self = shared_from_this(), msg = std::move(msg), interval_secs](asio::error_code const& ec) {
+                    if (ec) {
+                        return;
+                    }
+                    self->DoCalc(msg, interval_secs);
+                });
     }
 }
 
+void TimelordClient::CancelCalc(uint256 const& challenge) {
+    if (challenge != calc_challenge_ || !ptimer_sender_) {
+        return;
+    }
+    asio::error_code ignored_ec;
+    ptimer_sender_->cancel(ignored_ec);
+    ptimer_sender_.reset();
+}
+
 void TimelordClient::Connect(std::string const& host, unsigned short port) {
+    framing_requested_ = false;
     auto weak_self = std::weak_ptr<TimelordClient>(shared_from_this());
+    pclient_->SetProofHandler([weak_self](uint256 const& challenge, ProofDetail const& detail) {
+        auto self = weak_self.lock();
+        if (self == nullptr) {
+            return;
+        }
+        self->HandleProof(challenge, detail);
+    });
     pclient_->Connect(
             host, port,
             [weak_self]() {
@@ -245,6 +651,8 @@ void TimelordClient::Connect(std::string const& host, unsigned short port) {
                     return;
                 }
                 self->conn_handler_();
+                // The first PONG measures the round-trip time and tells the framings the front-end supports
+                self->SendPing();
                 self->DoWriteNextPing();
             },
             [weak_self](UniValue const& msg) {
@@ -283,15 +691,23 @@ void TimelordClient::DoWriteNextPing() {
         if (ec) {
             return;
         }
-        UniValue msg(UniValue::VOBJ);
-        msg.pushKV("id", static_cast<int>(TimelordClientMsgs::PING));
-        if (self->pclient_->SendMessage(msg)) {
-            self->DoWaitPong();
+        if (self->SendPing()) {
             self->DoWriteNextPing();
         }
     });
 }
 
+bool TimelordClient::SendPing() {
+    UniValue msg(UniValue::VOBJ);
+    msg.pushKV("id", static_cast<int>(TimelordClientMsgs::PING));
+    if (!pclient_->SendMessage(msg)) {
+        return false;
+    }
+    ping_sent_ = std::chrono::steady_clock::now();
+    DoWaitPong();
+    return true;
+}
+
 void TimelordClient::DoWaitPong() {
     ptimer_waitpong_.reset(new asio::steady_timer(ioc_));
     ptimer_waitpong_->expires_after(std::chrono::seconds(WAIT_PONG_TIMEOUT_SECONDS));
@@ -304,3 +720,14 @@ void TimelordClient::DoWaitPong() {
         }
     });
 }
+
+void TimelordClient::HandleProof(uint256 const& challenge, ProofDetail const& detail) {
+    if (pstats_ && !calc_answered_ && challenge == calc_challenge_ && detail.iters >= calc_iters_) {
+        calc_answered_ = true;
+        pstats_->AddProofArrival(
+                std::chrono::duration_cast<TimelordStats::Duration>(std::chrono::steady_clock::now() - calc_start_));
+    }
+    if (proof_receiver_) {
+        proof_receiver_(challenge, detail);
+    }
+}
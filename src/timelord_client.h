@@ -1,7 +1,9 @@
 #ifndef TIMELORD_CLIENT_H
 #define TIMELORD_CLIENT_H
 
+#include <chrono>
 #include <functional>
+#include <string>
 
 #include <vector>
 #include <deque>
@@ -18,6 +20,44 @@ using error_code = asio::error_code;
 
 class UniValue;
 
+struct ProofDetail {
+    Bytes y;
+    Bytes proof;
+    uint8_t witness_type;
+    uint64_t iters;
+    int duration;
+};
+
+/// The proof carried by a FRAME_PROOF frame, see `FrontEndClient`
+struct ProofFrame {
+    uint16_t msg_id{0};
+    uint256 challenge;
+    ProofDetail detail;
+};
+
+/**
+ * @brief Decode the payload of a FRAME_PROOF frame, it is the data after the frame type
+ *
+ * @return false when the payload is truncated, it has extra bytes, a varint overflows or the msg id is neither PROOF
+ * nor CALC_REPLY
+ */
+bool DecodeProofFrame(uint8_t const* data, std::size_t size, ProofFrame& out);
+
+/**
+ * @brief The client to a timelord front-end
+ *
+ * The messages are NUL-terminated JSON strings. The front-end can switch the messages it sends to the binary framing
+ * after the client asks for it, the client only asks after the front-end lists the framing in the `framings` of a
+ * PONG (see `TimelordClient`), then each message is a frame:
+ *
+ *   [u32 big-endian payload size][u8 frame type][payload]
+ *
+ * - FRAME_JSON: the payload is a JSON message without the NUL terminator
+ * - FRAME_PROOF: [u16 big-endian msg id][32 bytes challenge (uint256 byte order)][100 bytes y][u8 witness type]
+ *   [varint iters][varint duration][varint proof size][proof], the varints are unsigned LEB128
+ *
+ * The messages sent by the client are always JSON.
+ */
 class FrontEndClient : public std::enable_shared_from_this<FrontEndClient> {
 public:
     enum class ErrorType { CONN, READ, WRITE };
@@ -26,44 +66,131 @@ public:
     using ConnectionHandler = std::function<void()>;
     using MessageHandler = std::function<void(UniValue const&)>;
     using ErrorHandler = std::function<void(ErrorType err_type, std::string const& errs)>;
+    using ProofHandler = std::function<void(uint256 const& challenge, ProofDetail const& detail)>;
+
+    static uint8_t const FRAME_JSON = 1;
+    static uint8_t const FRAME_PROOF = 2;
 
     explicit FrontEndClient(asio::io_context& ioc);
 
     ~FrontEndClient();
 
+    /**
+     * @brief Resolve the host and connect to it asynchronously
+     *
+     * The connections to the resolved addresses are raced (happy eyeballs): the next address is tried when the
+     * current one fails or doesn't connect in a short delay, the first connected one wins. The error handler is
+     * called when no address connects before the timeout.
+     */
     void Connect(std::string const& host, unsigned short port, ConnectionHandler conn_handler,
                  MessageHandler msg_handler, ErrorHandler err_handler);
 
     bool SendMessage(UniValue const& msg);
 
+    /// Make the NUL-terminated data of the message, it can be sent many times without being serialized again
+    static std::shared_ptr<std::string const> Serialize(UniValue const& msg);
+
+    bool SendSerialized(std::shared_ptr<std::string const> data);
+
+    /// The proofs from the binary frames are passed to the handler, it must be set before connecting
+    void SetProofHandler(ProofHandler proof_handler);
+
+    /// Read the following messages as binary frames, it should be called from the message handler
+    void SwitchToBinaryFraming();
+
     void Exit();
 
 private:
+    struct ConnectRace;
+
+    void DoConnect(tcp::resolver::results_type const& results);
+
+    void DoStartNextAttempt(std::shared_ptr<ConnectRace> race);
+
+    /// The race is over, `psocket` is the connected socket or nullptr when it fails
+    void FinishConnect(std::shared_ptr<ConnectRace> race, std::shared_ptr<tcp::socket> psocket,
+                       std::string const& errs);
+
+    void StopConnect();
+
     void DoReadNext();
 
+    void DoReadNextFrame();
+
+    /// Parse the frame from the read buffer, returns false when the frame is invalid
+    bool HandleFrame(uint8_t const* data, std::size_t size);
+
     void DoSendNext();
 
     asio::io_context& ioc_;
     std::atomic<Status> st_{Status::READY};
+    tcp::resolver resolver_;
+    std::shared_ptr<ConnectRace> race_;
     tcp::socket s_;
     asio::streambuf read_buf_;
-    std::vector<uint8_t> send_buf_;
-    std::deque<std::string> sending_msgs_;
+    bool binary_framing_{false};
+    std::deque<std::shared_ptr<std::string const>> sending_msgs_;  // waiting for the running write
+    std::vector<std::shared_ptr<std::string const>> writing_msgs_;  // empty when no write is running
+    std::vector<asio::const_buffer> write_bufs_;
     ConnectionHandler conn_handler_;
     MessageHandler msg_handler_;
     ErrorHandler err_handler_;
-};
-
-struct ProofDetail {
-    Bytes y;
-    Bytes proof;
-    uint8_t witness_type;
-    uint64_t iters;
-    int duration;
+    ProofHandler proof_handler_;
 };
 
 using ProofReceiver = std::function<void(uint256 const& challenge, ProofDetail const& detail)>;
 
+/// The latencies of a timelord endpoint, it is only accessed from the io thread
+class TimelordStats {
+public:
+    using Duration = std::chrono::milliseconds;
+
+    void AddRoundTrip(Duration rtt);
+
+    /// The time from sending the CALC to receiving the proof which satisfies it
+    void AddProofArrival(Duration latency);
+
+    /// The proof from this endpoint is the first one which satisfies the request
+    void AddWin();
+
+    /// The smoothed round-trip time, zero when it isn't measured
+    Duration GetRoundTrip() const { return avg_rtt_; }
+
+    /// The smoothed proof arrival time, zero when no proof is received
+    Duration GetProofArrival() const { return avg_proof_arrival_; }
+
+    /// The connection is established
+    void AddConnected();
+
+    /// The connection fails or it is lost
+    void AddFailure();
+
+    /**
+     * @brief How well the endpoint works, in (0, 1], the higher the better
+     *
+     * It goes down when the PONGs arrive slowly and when the recent connections fail. The proof arrival time isn't
+     * used, it depends on the iters of the challenge more than on the endpoint.
+     */
+    double GetHealthScore() const;
+
+    /// The round-trip time is measured at least once, the health score of the endpoint means something
+    bool HasSamples() const { return num_rtts_ > 0; }
+
+    int GetNumOfProofs() const { return num_proofs_; }
+
+    int GetNumOfWins() const { return num_wins_; }
+
+    std::string ToString() const;
+
+private:
+    int num_rtts_{0};
+    Duration avg_rtt_{0};
+    int num_proofs_{0};
+    Duration avg_proof_arrival_{0};
+    int num_wins_{0};
+    double failure_rate_{0};  // smoothed, 1 means all the recent connections fail
+};
+
 class TimelordClient : public std::enable_shared_from_this<TimelordClient> {
 public:
     using ConnectionHandler = std::function<void()>;
@@ -80,9 +207,15 @@ public:
 
     void SetProofReceiver(ProofReceiver proof_receiver);
 
+    /// The latencies are recorded to the stats, it is kept by the caller so it survives the reconnections
+    void SetStats(std::shared_ptr<TimelordStats> pstats);
+
     void Calc(uint256 const& challenge, uint64_t iters, uint256 const& group_hash, uint64_t total_size,
               int interval_secs);
 
+    /// Stop re-sending the CALC of the challenge, the proof is already received
+    void CancelCalc(uint256 const& challenge);
+
     void Connect(std::string const& host, unsigned short port);
 
     void Exit();
@@ -90,10 +223,18 @@ public:
 private:
     explicit TimelordClient(asio::io_context& ioc);
 
+    /// Send the serialized CALC message, and send it again after every `interval_secs`
+    void DoCalc(std::shared_ptr<std::string const> msg, int interval_secs);
+
+    /// Send a PING now and wait for the PONG, returns false when the message cannot be sent
+    bool SendPing();
+
     void DoWriteNextPing();
 
     void DoWaitPong();
 
+    void HandleProof(uint256 const& challenge, ProofDetail const& detail);
+
     asio::io_context& ioc_;
     std::shared_ptr<FrontEndClient> pclient_;
     std::map<int, MessageHandler> msg_handlers_;
@@ -103,6 +244,14 @@ private:
     ConnectionHandler conn_handler_;
     ErrorHandler err_handler_;
     ProofReceiver proof_receiver_;
+    std::shared_ptr<TimelordStats> pstats_;
+    // the latest CALC, the proof arrival time is measured from the first time it is sent
+    uint256 calc_challenge_;
+    uint64_t calc_iters_{0};
+    std::chrono::steady_clock::time_point calc_start_;
+    bool calc_answered_{false};
+    std::chrono::steady_clock::time_point ping_sent_;
+    bool framing_requested_{false};
 };
 
 #endif
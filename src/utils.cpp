@@ -1,12 +1,28 @@
 #include "utils.h"
 
+#include <algorithm>
 #include <sstream>
 
 namespace chiapos {
 
-Bytes MakeBytes(uint256 const& val) { return BytesFromHex(val.ToString()); }
+void WriteUint256Bytes(uint256 const& val, uint8_t* out) { std::reverse_copy(val.begin(), val.end(), out); }
 
-uint256 MakeUint256(Bytes const& vchBytes) { return uint256S(BytesToHex(vchBytes)); }
+Bytes MakeBytes(uint256 const& val) {
+    Bytes res(val.size());
+    WriteUint256Bytes(val, res.data());
+    return res;
+}
+
+uint256 MakeUint256(uint8_t const* p, size_t size) {
+    uint256 res;
+    size_t n = std::min<size_t>(size, res.size());
+    std::reverse_copy(p + size - n, p + size, res.begin());
+    return res;
+}
+
+uint256 MakeUint256(Bytes const& vchBytes) { return MakeUint256(vchBytes.data(), vchBytes.size()); }
+
+uint256 MakeUint256(sha256::Digest const& digest) { return MakeUint256(digest.data(), digest.size()); }
 
 Bytes StrToBytes(std::string str) {
     Bytes b;
@@ -15,75 +31,74 @@ Bytes StrToBytes(std::string str) {
     return b;
 }
 
+namespace {
+
 char const hex_chars[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
 
-char Byte4bToHexChar(uint8_t hex) { return hex_chars[hex]; }
+/// The value of each hex character, -1 for invalid characters
+struct HexTable {
+    int8_t values[256];
 
-uint8_t HexCharToByte4b(char ch) {
-    if (ch >= 'A' && ch <= 'F') {
-        ch = std::tolower(ch);
-    }
-    if (ch >= '0' && ch <= '9') {
-        return ch - '0';
+    HexTable() {
+        memset(values, -1, sizeof(values));
+        for (int i = 0; i < 10; ++i) {
+            values['0' + i] = i;
+        }
+        for (int i = 0; i < 6; ++i) {
+            values['a' + i] = 10 + i;
+            values['A' + i] = 10 + i;
+        }
     }
-    if (ch >= 'a' && ch <= 'f') {
-        return ch - 'a' + 10;
+};
+
+HexTable const hex_table;
+
+uint8_t HexCharToByte4b(char ch) {
+    int8_t val = hex_table.values[static_cast<uint8_t>(ch)];
+    if (val < 0) {
+        // Not found, the character is invalid
+        std::stringstream err_ss;
+        err_ss << "invalid hex character (" << static_cast<int>(ch) << ") in order to convert into number";
+        throw std::runtime_error(err_ss.str());
     }
-    // Not found, the character is invalid
-    std::stringstream err_ss;
-    err_ss << "invalid hex character (" << static_cast<int>(ch) << ") in order to convert into number";
-    throw std::runtime_error(err_ss.str());
+    return val;
 }
 
-std::string ByteToHex(uint8_t byte) {
-    std::string hex(2, '0');
-    uint8_t hi = (byte & 0xf0) >> 4;
-    uint8_t lo = byte & 0x0f;
-    hex[0] = Byte4bToHexChar(hi);
-    hex[1] = Byte4bToHexChar(lo);
-    return hex;
-}
+}  // namespace
 
-uint8_t ByteFromHex(std::string const& hex, int* consumed) {
-    int actual_len = strlen(hex.c_str());
-    if (actual_len == 0) {
-        if (consumed) {
-            *consumed = 0;
-        }
-        return 0;
-    }
-    if (actual_len == 1) {
-        if (consumed) {
-            *consumed = 1;
-        }
-        return HexCharToByte4b(hex[0]);
-    }
-    uint8_t byte = (static_cast<int>(HexCharToByte4b(hex[0])) << 4) + HexCharToByte4b(hex[1]);
-    if (consumed) {
-        *consumed = 2;
+std::string BytesToHex(uint8_t const* p, size_t size) {
+    std::string res(size * 2, '0');
+    for (size_t i = 0; i < size; ++i) {
+        res[i * 2] = hex_chars[p[i] >> 4];
+        res[i * 2 + 1] = hex_chars[p[i] & 0x0f];
     }
-    return byte;
+    return res;
 }
 
-std::string BytesToHex(Bytes const& bytes) {
-    std::stringstream ss;
-    for (uint8_t byte : bytes) {
-        ss << ByteToHex(byte);
+std::string BytesToHex(Bytes const& bytes) { return BytesToHex(bytes.data(), bytes.size()); }
+
+Bytes BytesFromHex(std::string const& hex) {
+    // The string ends at the first '\0', a single character at the end makes the last byte
+    size_t len = strlen(hex.c_str());
+    Bytes res((len + 1) / 2);
+    for (size_t i = 0; i < len / 2; ++i) {
+        res[i] = (HexCharToByte4b(hex[i * 2]) << 4) | HexCharToByte4b(hex[i * 2 + 1]);
+    }
+    if (len % 2 == 1) {
+        res.back() = HexCharToByte4b(hex[len - 1]);
     }
-    return ss.str();
+    return res;
 }
 
-Bytes BytesFromHex(std::string hex) {
-    Bytes res;
-    int consumed;
-    uint8_t byte = ByteFromHex(hex, &consumed);
-    while (consumed > 0) {
-        res.push_back(byte);
-        hex = hex.substr(consumed);
-        // Next byte
-        byte = ByteFromHex(hex, &consumed);
+void BytesFromHex(std::string const& hex, uint8_t* out, size_t size) {
+    if (hex.size() != size * 2) {
+        std::stringstream err_ss;
+        err_ss << "invalid length of hex string, " << size * 2 << " characters are required, got " << hex.size();
+        throw std::runtime_error(err_ss.str());
+    }
+    for (size_t i = 0; i < size; ++i) {
+        out[i] = (HexCharToByte4b(hex[i * 2]) << 4) | HexCharToByte4b(hex[i * 2 + 1]);
     }
-    return res;
 }
 
 BytesConnector& BytesConnector::Connect(Bytes const& vchData) {
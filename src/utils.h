@@ -10,6 +10,9 @@
 
 namespace chiapos {
 
+/// Write the 32 bytes of a uint256 to `out`, in the same order as MakeBytes(uint256)
+void WriteUint256Bytes(uint256 const& val, uint8_t* out);
+
 Bytes MakeBytes(uint256 const& val);
 
 template <typename T, typename... Args>
@@ -32,11 +35,48 @@ std::array<uint8_t, N> MakeArray(Bytes const& val) {
     return res;
 }
 
+/**
+ * Convert bytes to uint256, the bytes are treated as a big-endian number
+ *
+ * @param p The bytes, only the last 32 bytes are used when there are more
+ * @param size How many bytes
+ *
+ * @return The number
+ */
+uint256 MakeUint256(uint8_t const* p, size_t size);
+
 uint256 MakeUint256(Bytes const& vchBytes);
 
+uint256 MakeUint256(sha256::Digest const& digest);
+
+std::string BytesToHex(uint8_t const* p, size_t size);
+
 std::string BytesToHex(Bytes const& bytes);
 
-Bytes BytesFromHex(std::string hex);
+template <size_t N>
+std::string BytesToHex(std::array<uint8_t, N> const& val) {
+    return BytesToHex(val.data(), val.size());
+}
+
+Bytes BytesFromHex(std::string const& hex);
+
+/**
+ * Decode a hex string into a buffer without allocation
+ *
+ * @param hex The hex string, must be `size * 2` characters
+ * @param out The buffer to write
+ * @param size The size of the buffer
+ *
+ * @exception std::runtime_error the length doesn't match or invalid characters are found
+ */
+void BytesFromHex(std::string const& hex, uint8_t* out, size_t size);
+
+template <size_t N>
+std::array<uint8_t, N> MakeArrayFromHex(std::string const& hex) {
+    std::array<uint8_t, N> res;
+    BytesFromHex(hex, res.data(), res.size());
+    return res;
+}
 
 class BytesConnector {
     static void ConnectBytesList(BytesConnector& connector) {}
@@ -91,25 +131,35 @@ private:
  */
 Bytes SubBytes(Bytes const& bytes, int start, int count = 0);
 
-inline void MakeSHA256Impl(CSHA256& sha256) {}
+inline void MakeSHA256Impl(sha256::Hasher& hasher) {}
 
-inline void MakeSHA256_WriteData(CSHA256& sha256, Bytes const& data) { sha256.Write(data.data(), data.size()); }
+inline void MakeSHA256_WriteData(sha256::Hasher& hasher, Bytes const& data) { hasher.Write(data.data(), data.size()); }
 
-inline void MakeSHA256_WriteData(CSHA256& sha256, uint256 const& data) { sha256.Write(data.begin(), data.size()); }
+inline void MakeSHA256_WriteData(sha256::Hasher& hasher, uint256 const& data) { hasher.Write(data.begin(), data.size()); }
+
+template <size_t N>
+void MakeSHA256_WriteData(sha256::Hasher& hasher, std::array<uint8_t, N> const& data) {
+    hasher.Write(data.data(), data.size());
+}
 
 template <typename T, typename... TS>
-void MakeSHA256Impl(CSHA256& sha256, T&& data, TS&&... params) {
-    MakeSHA256_WriteData(sha256, std::forward<T>(data));
-    MakeSHA256Impl(sha256, std::forward<TS>(params)...);
+void MakeSHA256Impl(sha256::Hasher& hasher, T&& data, TS&&... params) {
+    MakeSHA256_WriteData(hasher, std::forward<T>(data));
+    MakeSHA256Impl(hasher, std::forward<TS>(params)...);
+}
+
+/// Hash all parameters in order, the digest is returned on stack
+template <typename... T>
+sha256::Digest MakeSHA256Digest(T&&... params) {
+    sha256::Hasher hasher;
+    MakeSHA256Impl(hasher, std::forward<T>(params)...);
+    return hasher.Finalize();
 }
 
 template <typename... T>
 Bytes MakeSHA256(T&&... params) {
-    CSHA256 sha256;
-    MakeSHA256Impl(sha256, std::forward<T>(params)...);
-    Bytes res(CSHA256::OUTPUT_SIZE);
-    sha256.Finalize(res.data());
-    return res;
+    sha256::Digest digest = MakeSHA256Digest(std::forward<T>(params)...);
+    return Bytes(std::begin(digest), std::end(digest));
 }
 
 std::string FormatNumberStr(std::string const& num_str);
@@ -23,12 +23,8 @@ VdfForm MakeZeroForm() {
 VdfForm MakeVDFForm(Bytes const& vchData) { return MakeArray<VDF_FORM_SIZE>(vchData); }
 
 uint256 MakeChallenge(uint256 const& challenge, Bytes const& proof) {
-    CSHA256 sha;
-    sha.Write(challenge.begin(), challenge.size());
-    sha.Write(proof.data(), proof.size());
-
     uint256 res;
-    sha.Finalize(res.begin());
+    sha256::Hasher().Write(challenge.begin(), challenge.size()).Write(proof.data(), proof.size()).Finalize(res.begin());
     return res;
 }
 